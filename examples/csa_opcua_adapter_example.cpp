@@ -185,7 +185,13 @@ int main() {
 	
 	// Only for Sin ValueGenerator
 	mgr = new ipc_manager();
-	valGen = new runtime_value_generator(devManager, syncDevUtility);
+	// An enabled update pump receives the new values at once instead of at its interval
+	csa_update_pump *pump = csaOPCUA->getUpdatePump();
+	valGen = new runtime_value_generator(devManager, syncDevUtility, [pump]() {
+		if(pump != nullptr) {
+			pump->wakeup();
+		}
+	});
 	mgr->addObject(valGen);
 	mgr->doStart();	
 	
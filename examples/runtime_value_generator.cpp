@@ -33,9 +33,10 @@ using std::cout;
 using std::endl;
 using namespace ChimeraTK;
 	 
-runtime_value_generator::runtime_value_generator(boost::shared_ptr<DevicePVManager> devManager, boost::shared_ptr<DeviceSynchronizationUtility> syncDevUtility) {
+runtime_value_generator::runtime_value_generator(boost::shared_ptr<DevicePVManager> devManager, boost::shared_ptr<DeviceSynchronizationUtility> syncDevUtility, std::function<void()> valuesWritten) {
 	this->devManager = devManager;
 	this->syncDevUtility = syncDevUtility;
+	this->valuesWritten = valuesWritten;
 	this->doStart();
 }
 
@@ -45,7 +46,7 @@ runtime_value_generator::~runtime_value_generator() {
 	}
 }
 
-void runtime_value_generator::generateValues(boost::shared_ptr<DevicePVManager> devManager, boost::shared_ptr<DeviceSynchronizationUtility> syncDevUtility) {
+void runtime_value_generator::generateValues(boost::shared_ptr<DevicePVManager> devManager, boost::shared_ptr<DeviceSynchronizationUtility> syncDevUtility, std::function<void()> valuesWritten) {
 	// Time meassureing
 	clock_t start, end;
 	start = clock();
@@ -68,6 +69,9 @@ void runtime_value_generator::generateValues(boost::shared_ptr<DevicePVManager>
 		devManager->getProcessArray<int32_t>("int_sine")->write();
 		devManager->getProcessArray<int32_t>("t")->accessChannel(0) = vector<int32_t> {(int32_t)((end - start)/(CLOCKS_PER_SEC/1000))};
 		devManager->getProcessArray<int32_t>("t")->write();
+		if(valuesWritten) {
+			valuesWritten();
+		}
 		
 		usleep(devManager->getProcessArray<int32_t>("dt")->accessChannel(0).at(0));
 		end = clock();
@@ -106,6 +110,9 @@ void runtime_value_generator::generateValues(boost::shared_ptr<DevicePVManager>
 		}
 		testDoubleArray->write();
 		testIntArray->write();
+		if(valuesWritten) {
+			valuesWritten();
+		}
 		
 		syncDevUtility->receiveAll();
 	}
@@ -113,20 +120,12 @@ void runtime_value_generator::generateValues(boost::shared_ptr<DevicePVManager>
 }
 
 void runtime_value_generator::workerThread() {
-	bool run = true;
-	
-	thread *valueGeneratorThread = new std::thread(generateValues, this->devManager, this->syncDevUtility);
+	thread *valueGeneratorThread = new std::thread(generateValues, this->devManager, this->syncDevUtility, this->valuesWritten);
 	
-	while (run == true) {
-		if (! this->isRunning()) {
-			run = false;
-		}
-		sleep(1);
-	}
+	this->waitForStop();
 	
-	if(valueGeneratorThread->joinable()) {
-		valueGeneratorThread->join();
-	}
+	// The generator loops until the process ends, doStop must not wait for it
+	valueGeneratorThread->detach();
 	delete valueGeneratorThread;
 }
 
@@ -21,6 +21,8 @@
 #ifndef RUN_TIME_VALUE_GENERATOR_H
 #define RUN_TIME_VALUE_GENERATOR_H
 
+#include <functional>
+
 #include "ipc_managed_object.h"
 #include "ChimeraTK/ControlSystemAdapter/DeviceSynchronizationUtility.h"
 
@@ -30,12 +32,14 @@ class runtime_value_generator : public ipc_managed_object {
 private:   
 	boost::shared_ptr<DevicePVManager> devManager;
 	boost::shared_ptr<DeviceSynchronizationUtility> syncDevUtility;
+	// Called after every batch of written values, e.g. to wake the update pump
+	std::function<void()> valuesWritten;
     
 public:
-	runtime_value_generator(boost::shared_ptr<DevicePVManager> devManager, boost::shared_ptr<DeviceSynchronizationUtility> syncDevUtility);
+	runtime_value_generator(boost::shared_ptr<DevicePVManager> devManager, boost::shared_ptr<DeviceSynchronizationUtility> syncDevUtility, std::function<void()> valuesWritten);
 	~runtime_value_generator();
 	void workerThread();
-	static void generateValues(boost::shared_ptr<DevicePVManager> devManager, boost::shared_ptr<DeviceSynchronizationUtility> syncDevUtility);
+	static void generateValues(boost::shared_ptr<DevicePVManager> devManager, boost::shared_ptr<DeviceSynchronizationUtility> syncDevUtility, std::function<void()> valuesWritten);
     
 };
 
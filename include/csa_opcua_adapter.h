@@ -26,6 +26,7 @@
 
 #include "ua_adapter.h"
 #include "ua_processvariable.h"
+#include "csa_update_pump.h"
 
 #include "ChimeraTK/ControlSystemAdapter/ControlSystemPVManager.h"
 #include "ChimeraTK/ControlSystemAdapter/ApplicationBase.h"
@@ -46,6 +47,7 @@ class csa_opcua_adapter {
 private:
 	ipc_manager    *mgr;
 	ua_uaadapter *adapter;
+	csa_update_pump *pump;
 	boost::shared_ptr<ControlSystemPVManager> csManager;
 	
 	/**
@@ -62,6 +64,12 @@ private:
 	 * processvaribale are mapped in special folder, will be renamed, get description or a other engineering unit.
 	 */
 	void csa_opcua_adapter_InitVarMapping();
+	
+	/**
+	 * @brief Hand all mapped processvariables, which only receive values, over to an update pump. The pump receives them in its own thread,
+	 * so client reads are served from the latest received value. The pump is only created if the config enables it with updatePump="true".
+	 */
+	void csa_opcua_adapter_InitUpdatePump();
     
 public:
 	/**
@@ -99,6 +107,15 @@ public:
 	 */
 	ipc_manager* getIPCManager();
 	
+	/**
+	 * @brief Return the update pump, which receives the processvariables
+	 * 
+	 * The pump receives at its interval, the device side may call csa_update_pump::wakeup() after it sent new values to receive them at once.
+	 * 
+	 * @return Return the csa_update_pump, nullptr if the config does not enable it
+	 */
+	csa_update_pump* getUpdatePump();
+	
 	/**
 	 * @brief Start all objects in single threads for this case only the opc ua server
 	 * 
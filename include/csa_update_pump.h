@@ -0,0 +1,154 @@
+/* 
+ * This file is part of ChimeraTKs ControlSystem-OPC-UA-Adapter.
+ *
+ * ChimeraTKs ControlSystem-OPC-UA-Adapter is free software: you can 
+ * redistribute it and/or modify it under the terms of the Lesser GNU 
+ * General Public License as published by the Free Software Foundation, 
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ChimeraTKs ControlSystem-OPC-UA-Adapter is distributed in the hope 
+ * that it will be useful, but WITHOUT ANY WARRANTY; without even the 
+ * implied warranty ofMERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+ * See the Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Foobar.  If not, see https://www.gnu.org/licenses/lgpl.html
+ * 
+ * Copyright (c) 2016 Chris Iatrou <Chris_Paul.Iatrou@tu-dresden.de>
+ * Copyright (c) 2016 Julian Rahm  <Julian.Rahm@tu-dresden.de>
+ */
+
+#ifndef CSA_UPDATE_PUMP_H
+#define CSA_UPDATE_PUMP_H
+
+#include <functional>
+#include <list>
+#include <mutex>
+#include <vector>
+
+#include "ipc_managed_object.h"
+#include "ua_processvariable.h"
+
+#include "ChimeraTK/ControlSystemAdapter/ControlSystemPVManager.h"
+#include "ChimeraTK/ControlSystemAdapter/ControlSystemSynchronizationUtility.h"
+#include "ChimeraTK/ControlSystemAdapter/ProcessVariableListener.h"
+
+using namespace ChimeraTK;
+using namespace std;
+
+/** @class csa_update_pump
+ *	@brief This class receives all pumped process variables in its own thread and publishes their latest value.
+ *
+ * Without a pump every client read receives the pending updates of a process variable inline on the server thread.
+ * The pump takes over receiving, so reads are served from the latest published value in constant time and a process
+ * variable nobody reads does not build up a backlog. The pump thread receives whenever wakeup() is called, e.g. by the
+ * device side after it sent new values, and after the interval at the latest.
+ *
+ *  @author Chris Iatrou, Julian Rahm
+ *  @date 22.11.2016
+ *
+ */
+class csa_update_pump : public ipc_managed_object {
+private:
+        /** @class csa_update_pump_listener
+         *  @brief Receive notification listener, which queues its process variable for publishing
+         */
+        class csa_update_pump_listener : public ProcessVariableListener {
+        public:
+                csa_update_pump_listener(csa_update_pump *pump, ua_processvariable *processvariable);
+                void notify(ProcessVariable::SharedPtr processVariable);
+
+                csa_update_pump    *pump;
+                ua_processvariable *processvariable;
+                bool                queued;
+                bool                changed;
+        };
+
+        boost::shared_ptr<ControlSystemSynchronizationUtility> syncUtility;
+        std::list<ProcessVariable::SharedPtr>                   pumpedProcessVariables;
+        std::vector<boost::shared_ptr<csa_update_pump_listener> > listeners;
+        std::vector<csa_update_pump_listener *>                 pending;
+        uint32_t                                                interval;
+        // Set by wakeup() under mtx_threadOperations, cleared by the pump thread before it receives
+        bool                                                    wakeupPending;
+
+        /* Monitored item push: process variables published by the pump thread are collected in changed, the server
+         * thread takes them over in notifyChanged and samples their monitored items */
+        UA_Server                                              *notifyServer;
+        std::mutex                                              changedMutex;
+        std::vector<csa_update_pump_listener *>                 changed;
+        // Wakes the server loop, which then calls notifyChanged
+        std::function<void()>                                   serverWakeup;
+
+        /* Process variables handed over while the pump is running, they are added by the pump thread */
+        std::mutex                                              lateMutex;
+        std::vector<ua_processvariable *>                       lateVariables;
+
+        /** @brief Publish the values of all process variables which received an update since the last call
+        */
+        void publishPending();
+
+public:
+        /** @brief Constructor of the class
+        *
+        * @param csManager PV-Manager of the process variables
+        * @param interval Longest time in ms between two receive cycles, a wakeup starts the next one earlier
+        */
+        csa_update_pump(boost::shared_ptr<ControlSystemPVManager> csManager, uint32_t interval);
+
+        /** @brief Destructor of the class, it stops the pump thread and waits for it
+        */
+        ~csa_update_pump();
+
+        /** @brief Hand a process variable over to the pump, this has to be done before the pump is started
+        *
+        * @param processvariable The process variable, process variables which can not be pumped are ignored
+        *
+        * @return True if the process variable is pumped
+        */
+        bool addVariable(ua_processvariable *processvariable);
+
+        /** @brief Hand a process variable over to the running pump, it is added by the pump thread before its next receive cycle
+        *
+        * @param processvariable The process variable, process variables which can not be pumped are ignored
+        */
+        void queueVariable(ua_processvariable *processvariable);
+
+        /** @brief Receive all pumped process variables once and publish the updated values
+        */
+        void pumpOnce();
+
+        /** @brief Wake the pump thread up for its next receive cycle, it is safe to call this from any thread
+        *
+        * Wakeups which arrive while the pump is receiving are merged into one further cycle.
+        */
+        void wakeup();
+
+        /** @brief Push the value changes of all pumped process variables into their monitored items
+        *
+        * The sampling interval of the monitored items is raised to the fallback interval, so unchanged values are not polled anymore.
+        * Changes are only pushed when the server thread calls notifyChanged, see setServerWakeup.
+        *
+        * @param server Server of the pumped process variables
+        * @param fallbackSamplingInterval Minimum sampling interval in ms of the monitored items
+        *
+        * @return True, this has to be done before the pump is started
+        */
+        bool enableMonitoredItemPush(UA_Server *server, UA_Double fallbackSamplingInterval);
+
+        /** @brief Sample the monitored items of all process variables published since the last call, this has to be called on the server thread
+        */
+        void notifyChanged();
+
+        /** @brief Set a function which wakes the server thread up whenever new changes wait for notifyChanged, this has to be done before the pump is started
+        *
+        * @param wakeup Called by the pump thread, nullptr to leave changes to the fallback sampling interval
+        */
+        void setServerWakeup(std::function<void()> wakeup);
+
+        /** @brief Receive and publish after every wakeup or interval until the thread is stopped
+        */
+        void workerThread();
+};
+
+#endif // CSA_UPDATE_PUMP_H
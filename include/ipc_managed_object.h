@@ -22,6 +22,8 @@
 #define IPC_MANAGED_OBJECT_H
 #include <thread>
 #include <mutex>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
 #include "stdint.h"
 
@@ -42,10 +44,34 @@ class ipc_manager;
 class ipc_managed_object {
 protected:
         uint32_t     ipc_id;
-        bool         thread_run;
+        // Written under mtx_threadOperations, volatile because the opcua server loop watches it directly
+        volatile bool thread_run;
         ipc_manager *manager;
         std::thread *threadTask;
         std::mutex   mtx_threadOperations;
+        // Notified whenever thread_run is cleared
+        std::condition_variable stateChanged;
+
+        /**
+         * @brief Block the calling worker until the object is stopped
+         *
+         */
+        void waitForStop();
+
+        /**
+         * @brief Block the calling worker until the object is stopped or the timeout elapsed
+         *
+         * @param timeout Longest time to wait
+         *
+         * @return True if the object was stopped
+         */
+        bool waitForStop(std::chrono::milliseconds timeout);
+
+        /**
+         * @brief Called by doStop after thread_run was cleared, workers which do not wait on stateChanged wake themselves up here
+         *
+         */
+        virtual void stopRequested();
 
 public:
         /**
@@ -120,7 +146,10 @@ public:
         bool isRunning();
 
         /**
-         * @brief Stop the thread
+         * @brief Stop the thread and wait until the worker returned
+         *
+         * The worker is woken up through stateChanged, so the call returns as soon as the worker noticed the stop.
+         * If the worker stops itself, it is not waited for.
          *
          * @return 0
          */
@@ -41,7 +41,6 @@ class ipc_manager : public ipc_managed_object {
 private:
   list<ipc_managed_object*> objects;
   uint32_t nxtId;
-  std::condition_variable   notifier;
 
         /**
          * @brief Constructor for ipc-ipc_managed_object
@@ -107,12 +106,6 @@ public:
          *
          */
         void stopAll();
-
-        /**
-         * @brief Cycle worker, while thread is runing an notification is generated.
-         *
-         */
-        void periodiclyKickWorkerThread();
 };
 
 #endif // HAVE_IPC_MANAGER_H
@@ -23,4 +23,11 @@
 // .... of AdditionalVariable
 #define CSA_NSID_ADDITIONAL_VARIABLE_VALUE 6002
 
+// Longest time in ms the update pump sleeps without a wakeup, after it the pump receives all process variables again
+#define CSA_UPDATE_PUMP_INTERVAL 100
+
+// Minimum sampling interval in ms of monitored items on pumped process variables, value changes are pushed by the
+// update pump and sampling is only a fallback
+#define CSA_MONITORED_ITEM_FALLBACK_INTERVAL 1000
+
 #endif
@@ -9859,6 +9859,45 @@ UA_Server_addRepeatedJob(UA_Server *server, UA_Job job,
 UA_StatusCode
 UA_Server_removeRepeatedJob(UA_Server *server, UA_Guid jobId);
 
+/* Get the time when the next repeated job is due. A main loop which waits on
+ * its own timers can sleep until then instead of the fixed maximum timeout of
+ * UA_Server_run_iterate.
+ *
+ * @param server The server object.
+ * @return The monotonic time (see UA_DateTime_nowMonotonic) of the next
+ *         repeated job, UA_INT64_MAX if there is none. */
+UA_DateTime
+UA_Server_getNextRepeatedJobTime(UA_Server *server);
+
+/* Run a callback once at the end of the current server iteration, after all
+ * messages received in the iteration were processed and answered. Callbacks
+ * which are still pending are run when the server is deleted.
+ *
+ * @param server The server object.
+ * @param callback The callback that shall be run.
+ * @param data Data handed to the callback.
+ * @return Upon success, UA_STATUSCODE_GOOD is returned.
+ *         An error code otherwise. */
+UA_StatusCode
+UA_Server_delayedCallback(UA_Server *server, UA_ServerCallback callback, void *data);
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+/**
+ * Monitored items
+ * --------------- */
+/* Sample all monitored items on the value attribute of a node right away,
+ * instead of waiting for their next sampling interval. This allows data
+ * sources to push a value change into the subscriptions. Must be called from
+ * the thread running the server, e.g. from a repeated job.
+ *
+ * @param server The server object.
+ * @param nodeId The node whose value has changed.
+ * @return Upon success, UA_STATUSCODE_GOOD is returned.
+ *         An error code otherwise. */
+UA_StatusCode
+UA_Server_triggerMonitoredItems(UA_Server *server, const UA_NodeId nodeId);
+#endif
+
 /**
  * Reading and Writing Node Attributes
  * -----------------------------------
@@ -10271,6 +10310,109 @@ UA_StatusCode
 UA_Server_setVariableNode_dataSource(UA_Server *server, const UA_NodeId nodeId,
                                      const UA_DataSource dataSource);
 
+/* Attach a data source together with the attributes describing it in a single
+ * edit of the node, so that the value is never read to infer its shape. The
+ * access level is used for the user access level as well. A NULL dataType
+ * keeps the dataType and valueRank of the node. */
+typedef struct {
+    UA_DataSource dataSource;
+    UA_Byte accessLevel;
+    UA_LocalizedText description;
+    const UA_DataType *dataType;
+    UA_Int32 valueRank;
+} UA_DataSourceAttributes;
+
+UA_StatusCode
+UA_Server_setVariableNode_dataSourceAttributes(UA_Server *server, const UA_NodeId nodeId,
+                                               const UA_DataSourceAttributes *attributes);
+
+/**
+ * Deadband
+ * ~~~~~~~~
+ * Monitored items on the value of a variable node, whose client requests no
+ * deadband of its own (or no DataChangeFilter at all), apply the deadband of
+ * the node. Only numeric values are filtered. Unlike the standard, percent
+ * deadbands are relative to the last reported value since the nodes carry no
+ * EURange. */
+UA_StatusCode
+UA_Server_setVariableNode_deadband(UA_Server *server, const UA_NodeId nodeId,
+                                   const UA_DeadbandType deadbandType,
+                                   const UA_Double deadbandValue);
+
+/**
+ * Node Snapshots
+ * ~~~~~~~~~~~~~~
+ * Serializes object and variable nodes together with their references into a
+ * binary buffer, so they can be inserted into the server of a later start
+ * without building them again. Data sources and value callbacks are not
+ * serialized: variables with a data source are restored with an empty value
+ * and have to be bound again.
+ *
+ * A reference target is outside of the snapshot if it lies in another
+ * namespace than the restored node, or if it is listed in ``remapFrom``. Such
+ * targets are replaced by the entry with the same index in ``remapTo`` and get
+ * the inverse reference added. If restoring fails, no node of the snapshot
+ * and no reference to one is left in the server. */
+UA_StatusCode
+UA_Server_encodeNodes(UA_Server *server, const UA_NodeId *nodeIds,
+                      size_t nodeIdsSize, UA_ByteString *dst);
+
+UA_StatusCode
+UA_Server_decodeNodes(UA_Server *server, const UA_ByteString *src,
+                      const UA_NodeId *remapFrom, const UA_NodeId *remapTo,
+                      size_t remapSize);
+
+/**
+ * Write Request Callback
+ * ~~~~~~~~~~~~~~~~~~~~~~
+ * Brackets every WriteRequest of a client, so that data sources can collect
+ * the writes of one request and apply them together. Local writes with
+ * UA_Server_write are not bracketed. */
+typedef struct {
+    /* Pointer to user-provided data for the callback */
+    void *handle;
+
+    /* Called before the first node of a WriteRequest is written */
+    void (*begin)(void *handle);
+
+    /* Called after all nodes of a WriteRequest were written.
+     *
+     * @param handle The handle of the callback
+     * @param failed True if writing at least one node failed
+     * @return Unless UA_STATUSCODE_GOOD is returned, the returned status
+     *         replaces the good results of the deferred writes */
+    UA_StatusCode (*end)(void *handle, UA_Boolean failed);
+
+    /* Number of writes the data sources deferred to end() since begin(). It
+     * is read after every node, so only the results of deferred writes are
+     * replaced. Writes which were applied right away keep their result. If
+     * NULL, the results of all good writes are replaced. */
+    size_t (*deferredWrites)(void *handle);
+} UA_WriteRequestCallback;
+
+void
+UA_Server_setWriteRequestCallback(UA_Server *server,
+                                  const UA_WriteRequestCallback callback);
+
+/**
+ * Node Access Callback
+ * ~~~~~~~~~~~~~~~~~~~~
+ * Called before a node is browsed or read and for every node that a
+ * TranslateBrowsePathsToNodeIds request passes on its way to the targets. The
+ * node does not need to exist, so the callback can add nodes on demand. The
+ * callback may change the nodestore, but must not remove the accessed node. */
+typedef struct {
+    /* Pointer to user-provided data for the callback */
+    void *handle;
+
+    /* Called with the NodeId of the accessed node */
+    void (*onAccess)(void *handle, const UA_NodeId *nodeId);
+} UA_NodeAccessCallback;
+
+void
+UA_Server_setNodeAccessCallback(UA_Server *server,
+                                const UA_NodeAccessCallback callback);
+
 /**
  * .. _value-callback:
  *
@@ -10439,6 +10581,18 @@ UA_Server_addObjectNode(UA_Server *server, const UA_NodeId requestedNewNodeId,
                                instantiationCallback, outNewNodeId);
 }
 
+/* Adds an object which references typeDefinition, but does not copy the members
+ * of the type. The caller adds the members itself, e.g. with NodeIds of its
+ * own. */
+UA_StatusCode
+UA_Server_addObjectNode_withoutMembers(UA_Server *server, const UA_NodeId requestedNewNodeId,
+                                       const UA_NodeId parentNodeId,
+                                       const UA_NodeId referenceTypeId,
+                                       const UA_QualifiedName browseName,
+                                       const UA_NodeId typeDefinition,
+                                       const UA_ObjectAttributes attr,
+                                       UA_NodeId *outNewNodeId);
+
 static UA_INLINE UA_StatusCode
 UA_Server_addObjectTypeNode(UA_Server *server, const UA_NodeId requestedNewNodeId,
                             const UA_NodeId parentNodeId,
@@ -11640,6 +11794,24 @@ extern "C" {
 UA_ServerNetworkLayer
 UA_ServerNetworkLayerTCP(UA_ConnectionConfig conf, UA_UInt16 port);
 
+/* Get the listening socket and the sockets of all open connections of a
+ * started TCP network layer, so an external main loop can wait on them. The
+ * set changes whenever getJobs accepts or closes a connection. A closed socket
+ * is removed from the set after it was closed, so its number may be reused by
+ * a later connection. Every accepted connection gets a new generation, which
+ * tells such connections apart. The listening socket has generation 0.
+ *
+ * @param nl A network layer created by UA_ServerNetworkLayerTCP.
+ * @param sockets Array which receives the sockets, may be NULL.
+ * @param generations Array which receives the generation of every socket, may
+ *        be NULL.
+ * @param socketsSize Size of the arrays.
+ * @return The number of sockets, which may be larger than socketsSize. */
+size_t
+UA_ServerNetworkLayerTCP_getSockets(const UA_ServerNetworkLayer *nl,
+                                    UA_Int32 *sockets, UA_UInt64 *generations,
+                                    size_t socketsSize);
+
 UA_Connection
 UA_ClientConnectionTCP(UA_ConnectionConfig conf, const char *endpointUrl, UA_Logger logger);
 
@@ -22,12 +22,15 @@
 #define MTCA_UAADAPTER_H
 
 #include <vector>
+#include <unordered_map>
+#include <functional>
 
 #include "ua_mapped_class.h"
 #include "ipc_managed_object.h"
 #include "ua_processvariable.h"
 #include "ua_additionalvariable.h"
-#include "xml_file_handler.h"
+#include "ua_write_batch.h"
+#include "ua_map_matcher.h"
 
 #include "ChimeraTK/ControlSystemAdapter/ControlSystemPVManager.h"
 
@@ -73,8 +76,114 @@ struct ServerConfig {
         string username = "";
         string applicationName = "OPCUA Adapter";
         uint16_t opcuaPort = 16664;
+        bool zeroCopyArrays = false;
+        bool atomicWrites = false;
+        /** @brief Receive the processvariables in an update pump thread instead of on every client read
+         */
+        bool updatePump = false;
+        /** @brief Create the processvariables and their mapped objects on first access instead of at startup
+         */
+        bool lazyInstantiation = false;
+        /** @brief File of the address space snapshot, which is loaded instead of building the variables if the inputs did not change. Empty to disable
+         */
+        string snapshotFile = "";
+};
+
+
+/** @struct MapEntry
+ *	@brief This struct represents one <map>-tag of the config file. All <map>-tags are parsed once, so mapping a variable does not query the xml document.
+ *
+ */
+struct MapEntry {
+        /** @brief Name of the process variable, or a glob or regex if the entry is a pattern rule
+         */
+        string sourceVariableName;
+        /** @brief True if the <map>-tag has match="glob" or match="regex". rename and <folder> may then use the captures $0 to $9
+         */
+        bool pattern = false;
+        /** @brief Name attribute of the parent <application>-tag
+         */
+        string applicationName;
+        string rename;
+        string engineeringUnit;
+        string description;
+        string deadbandAbsolute;
+        /** @brief Deadband in percent of the last reported value, not of an EURange as the standard percent deadband
+         */
+        string deadbandRelative;
+        /** @brief Concatenated pathSep of all <unrollPath>-tags which are set to True
+         */
+        string unrollPathSeparator;
+        bool unrollPath = false;
+        /** @brief Parsed path of every <folder>-tag, stops at the first empty folder if the path is unrolled
+         */
+        vector<vector<string>> folderPaths;
+        /** @brief Content of every <folder>-tag of a pattern rule, the captures are inserted before the path is parsed
+         */
+        vector<string> folderTemplates;
+};
+
+/** @struct AdditionalVariableEntry
+ *	@brief This struct represents one <variable>-tag of an <additionalNodes>-tag
+ *
+ */
+struct AdditionalVariableEntry {
+        string name;
+        string value;
+        string description;
+};
+
+/** @struct AdditionalNodesEntry
+ *	@brief This struct represents one <additionalNodes>-tag of the config file, it is kept until the server is constructed and the nodes are added
+ *
+ */
+struct AdditionalNodesEntry {
+        string folderName;
+        string description;
+        vector<AdditionalVariableEntry> variables;
+};
+
+/** @struct MappingPlan
+ *  @brief Resolved form of one <map>-tag for one process variable, prepared without touching the opcua server
+ */
+struct MappingPlan {
+        /** @brief The <map>-tag this plan was resolved from
+         */
+        const MapEntry *entry = nullptr;
+        /** @brief Display and browse name of the mapped object
+         */
+        string renameVar;
+        /** @brief Unrolled folder path of the variable, without the variable name itself
+         */
+        vector<string> varPathVector;
+        /** @brief Folder paths of a pattern rule with the captures inserted, exact entries use the paths of the entry
+         */
+        vector<vector<string>> folderPaths;
+        bool hasDeadband = false;
+        /** @brief False if the deadband string could not be parsed as a number
+         */
+        bool deadbandParsed = false;
+        UA_DeadbandType deadbandType = UA_DEADBANDTYPE_NONE;
+        double deadbandValue = 0;
+        string deadbandString;
+};
+
+/** @struct VariablePlan
+ *  @brief All mappings of one process variable, committed to the server in one go by <ua_uaadapter::addVariables>
+ */
+struct VariablePlan {
+        string name;
+        vector<MappingPlan> mappings;
 };
 
+/** @struct DeferredVariable
+ *  @brief A variable of the lazy instantiation mode, which is committed to the server on first access
+ */
+struct DeferredVariable {
+        VariablePlan plan;
+        boost::shared_ptr<ControlSystemPVManager> csManager;
+        bool committed = false;
+};
 
 /** @class ua_uaadapter
  *	@brief This class provide the opcua server and manage the variable mapping.
@@ -99,6 +208,9 @@ private:
         UA_NodeId 							constantsListId;
 
         vector<FolderInfo>			folderVector;
+        /* Folder trie: parent NodeId -> (folder name -> position in folderVector), so resolving a path costs one lookup per segment.
+         * The parent NodeIds are deep copies and are freed by the destructor */
+        unordered_map<UA_NodeId, unordered_map<string, size_t>, UA_NodeId_hasher, UA_NodeId_equalTo>	folderIndex;
         UA_NodeId								ownNodeId;
 
         ServerConfig 						serverConfig;
@@ -107,7 +219,53 @@ private:
         vector<ua_additionalvariable *> 	additionalVariables;
         vector<ua_processvariable *>			mappedVariables;
 
-        xml_file_handler *fileHandler;
+        vector<AdditionalNodesEntry>				additionalNodes;
+
+        vector<MapEntry>							mapEntries;
+        // sourceVariableName -> positions in mapEntries, one variable may be mapped more than once
+        unordered_map<string, vector<size_t>>	mapIndex;
+        // All pattern rules, rule number of mapMatcher -> position in mapEntries
+        ua_map_matcher							mapMatcher;
+        vector<size_t>							patternEntries;
+        // <include>- and <exclude>-tags of the <config>-tag, empty filters are not applied
+        ua_map_matcher							includeFilter;
+        ua_map_matcher							excludeFilter;
+        size_t									filteredCount;
+
+        ua_write_batch 					writeBatch;
+
+        /* Lazy instantiation: the folders are created at startup, the variables below them are committed when one of their
+         * parent folders or the Value node is accessed. The parent NodeIds are deep copies and are freed by the destructor */
+        vector<DeferredVariable>				deferredVariables;
+        size_t									deferredCount;
+        unordered_map<UA_NodeId, vector<size_t>, UA_NodeId_hasher, UA_NodeId_equalTo>	deferredByParent;
+        // Name of the processvariable, which is the string NodeId of its Value node -> position in deferredVariables
+        unordered_map<string, size_t>			deferredByName;
+        bool									committingDeferred;
+        std::function<void(ua_processvariable *)>	variableListener;
+
+        /* Address space snapshot: while the variables are built, the new nodes are collected for the snapshot file */
+        string									configPath;
+        bool									recordSnapshotNodes;
+        vector<UA_NodeId>						snapshotNodes;
+        bool									restoredFromSnapshot;
+
+        /* Server loop: an eventfd which other threads write to wake the loop up, and the function the loop then calls */
+        int										wakeupFd;
+        std::function<void()>					wakeupListener;
+
+        /** @brief Run the server until the object is stopped
+        *
+        * The loop waits with epoll on the sockets of the network layer, on wakeupFd and on a timerfd armed for the next
+        * repeated job. UA_Server_run_iterate is only called when one of them is ready, so an idle server does not wake up
+        * and a wakeup is handled at once instead of after the iterate timeout of the stack. A socket is only registered
+        * when it appears, the generation of its connection tells a reused socket number apart from an unchanged socket.
+        */
+        void runServerLoop();
+
+        /** @brief Wake the server loop, so it sees the cleared run flag
+        */
+        void stopRequested();
 
         /** @brief This methode construct the parameter for the opcua server, depending of the <serverConfig> struct
         */
@@ -128,11 +286,92 @@ private:
         */
         UA_NodeId createUAFolder(UA_NodeId basenodeId, string folderName, string description = "");
 
+        /** @brief Resolves the mapping plan of a variable from the <map>-tag index
+        *
+        * Only reads the parsed mapping configuration, hence it may be called from several threads at once.
+        *
+        * @param name Name of the process variable
+        */
+        VariablePlan prepareVariable(const string &name) const;
+
+        /** @brief Creates the processvariable and all of its mapped objects from a prepared plan
+        *
+        * @param plan Plan of the variable, see <prepareVariable>
+        * @param csManager Control system PV manager that holds the variable
+        */
+        void commitVariable(const VariablePlan &plan, boost::shared_ptr<ControlSystemPVManager> csManager);
+
+        /** @brief Lists a processvariable in the adapter and applies the server wide settings to it
+        *
+        * @param processvariable The processvariable, it is deleted by the adapter
+        */
+        void registerVariable(ua_processvariable *processvariable);
+
+        /** @brief Creates the mapped objects of a processvariable in its application folders
+        *
+        * @param plan Plan of the variable, see <prepareVariable>
+        * @param processvariable The processvariable, which is already mapped into the server
+        */
+        void commitMappings(const VariablePlan &plan, ua_processvariable *processvariable);
+
+        /** @brief Adds the variables from the snapshot file, or builds them and writes a new snapshot file
+        *
+        * @param plans Plans of the variables, see <prepareVariable>
+        * @param csManager Control system PV manager that holds the variables
+        */
+        void commitVariablesWithSnapshot(const vector<VariablePlan> &plans, boost::shared_ptr<ControlSystemPVManager> csManager);
+
+        /** @brief Hash over everything the variable nodes are built from, the mapping file and name, type, length, access, unit and description of the processvariables
+        *
+        * @param resolved The processvariables, in the order of the plans
+        *
+        * @return uint64_t
+        */
+        uint64_t hashSnapshotInputs(const vector<ua_processvariable *> &resolved);
+
+        /** @brief Restores the nodes of the snapshot file and binds the processvariables to them
+        *
+        * @param inputHash Hash of the current inputs, the snapshot is only loaded if it was written for the same hash
+        * @param resolved The processvariables, not mapped yet and in the order of the plans
+        *
+        * @return True if the snapshot was loaded, otherwise the server is unchanged
+        */
+        bool loadSnapshot(uint64_t inputHash, const vector<ua_processvariable *> &resolved);
+
+        /** @brief Writes the nodes collected while the variables were built into the snapshot file
+        *
+        * @param inputHash Hash of the current inputs
+        * @param firstFolder Position in folderVector of the first folder created while the variables were built
+        * @param resolved The processvariables, in the order of the plans
+        */
+        void saveSnapshot(uint64_t inputHash, size_t firstFolder, const vector<ua_processvariable *> &resolved);
+
+        /** @brief Creates the folders of one mapping, existing folders are reused
+        *
+        * @param mapping Resolved mapping of the variable
+        *
+        * @return The folders in which the mapped object is placed
+        */
+        vector<UA_NodeId> createMappingFolders(const MappingPlan &mapping);
+
+        /** @brief Creates the folders of a variable and defers the variable until one of them is accessed
+        *
+        * @param plan Plan of the variable, see <prepareVariable>
+        * @param csManager Control system PV manager that holds the variable
+        */
+        void deferVariable(const VariablePlan &plan, boost::shared_ptr<ControlSystemPVManager> csManager);
+
+        /** @brief Commits a deferred variable, if it was not committed yet
+        *
+        * @param pos Position in deferredVariables
+        */
+        void commitDeferredVariable(size_t pos);
+
 public:
 
         /** @brief Constructor of the class.
  *
- * During the construction of the class it instanciate a xml_file_handler and read the config, after that the server will be sonstructed and the namespace ist added to them.
+ * During the construction of the class it reads the config file in one streaming pass, after that the server will be sonstructed and the namespace ist added to them.
  * Concluding all additional nodes which are defined in the configFile are mapped into the server.
  *
  * @param configFile This file provide the configuration and the mapping of the server
@@ -159,7 +398,7 @@ public:
         */
         UA_NodeId createFolderPath(UA_NodeId basenodeid, vector<string> folderPathVector);
 
-        /** @brief Creates a folder in the given parent node
+        /** @brief Creates a folder in the given parent node, an existing folder with the same name is reused
         *
         * @param basenodeId Node id of the parent node
         * @param folderName Name of the new folder
@@ -178,6 +417,8 @@ public:
         *
         * @param basenodeId Node id of the parent node
         * @param folderName The name of folder, that be checked
+        *
+        * @return UA_NodeId of the folder, UA_NODEID_NULL if it does not exist
         */
         UA_NodeId existFolder(UA_NodeId basenodeid, string folderName);
 
@@ -188,6 +429,71 @@ public:
         */
         void addVariable(string name, boost::shared_ptr<ControlSystemPVManager> csManager);
 
+        /** @brief Adds many variables at once
+        *
+        * The mapping plans are resolved in parallel, the opcua nodes are then created by the calling thread in the given order.
+        *
+        * @param names Names of the process variables
+        * @param csManager Control system PV manager that holds the variables
+        */
+        void addVariables(const vector<string> &names, boost::shared_ptr<ControlSystemPVManager> csManager);
+
+        /** @brief Check if a process variable is dropped by the <include>- and <exclude>-tags of the config
+        *
+        * A variable is dropped if include patterns are set and none of them matches, or if any exclude pattern matches.
+        *
+        * @param name Name of the process variable
+        *
+        * @return True if the variable is not mapped
+        */
+        bool isFiltered(const string &name) const;
+
+        /** @brief Number of process variables which were passed to <addVariable> or <addVariables> and dropped by the filters
+        */
+        size_t getFilteredVariableCount();
+
+        /** @brief Commits the deferred variables below a node or with this Value node, this is called by the server before the node is browsed or read
+        *
+        * @param nodeId Node id of the accessed node
+        */
+        void accessNode(const UA_NodeId &nodeId);
+
+        /** @brief Returns the number of variables which are deferred by the lazy instantiation and not committed yet
+        *
+        * @return size_t
+        */
+        size_t getDeferredVariableCount();
+
+        /** @brief Check if the variables were restored from the snapshot file instead of being built
+        *
+        * @return bool
+        */
+        bool isRestoredFromSnapshot();
+
+        /** @brief Check if the config enables the update pump for the processvariables
+        *
+        * @return bool
+        */
+        bool isUpdatePumpEnabled();
+
+        /** @brief Set a listener which is called on the server thread for every variable committed by the lazy instantiation
+        *
+        * @param listener The listener, it gets the new processvariable
+        */
+        void setVariableListener(std::function<void(ua_processvariable *)> listener);
+
+        /** @brief Wake the server loop up from any thread, the wakeup listener is then called on the server thread
+        *
+        * Several wakeups before the loop runs are handled once.
+        */
+        void wakeup();
+
+        /** @brief Set a listener which is called on the server thread after every wakeup, before the server handles its jobs
+        *
+        * @param listener The listener, nullptr to remove it
+        */
+        void setWakeupListener(std::function<void()> listener);
+
         /** @brief Methode that returns the node id of the instanced class
         *
         * @return UA_NodeId
@@ -200,17 +506,26 @@ public:
         */
         vector<ua_processvariable *> getVariables();
 
+        /** @brief Methode that returns the opcua server of the adapter
+        *
+        * @return UA_Server
+        */
+        UA_Server* getMappedServer();
+
         /** @brief Create and start a thread for the opcua server instance
         *
         */
         void workerThread();
 
-        /** @brief This Methode reads the config-tag form the given <variableMap.xml>.
+        /** @brief This Methode reads the config-, additionalNodes- and map-tags from the given <variableMap.xml> in one forward pass.
+        *
+        * The file is read with a libxml2 text reader, so no document tree is built. All libxml2 memory is released before the methode returns.
         *
+        * @param configFile Path to the <variableMap.xml>, if empty the default configuration is used
         */
-        void readConfig();
+        void readConfig(string configFile);
 
-        /** @brief This Methode reads the additionaNode-tag from the given <variableMap.xml>
+        /** @brief This Methode adds the additionalNodes-tags read by <readConfig> to the server and releases them
         *
         */
         void readAdditionalNodes();
@@ -0,0 +1,156 @@
+/* 
+ * This file is part of ChimeraTKs ControlSystem-OPC-UA-Adapter.
+ *
+ * ChimeraTKs ControlSystem-OPC-UA-Adapter is free software: you can 
+ * redistribute it and/or modify it under the terms of the Lesser GNU 
+ * General Public License as published by the Free Software Foundation, 
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ChimeraTKs ControlSystem-OPC-UA-Adapter is distributed in the hope 
+ * that it will be useful, but WITHOUT ANY WARRANTY; without even the 
+ * implied warranty ofMERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+ * See the Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Foobar.  If not, see https://www.gnu.org/licenses/lgpl.html
+ * 
+ * Copyright (c) 2016 Chris Iatrou <Chris_Paul.Iatrou@tu-dresden.de>
+ * Copyright (c) 2016 Julian Rahm  <Julian.Rahm@tu-dresden.de>
+ */
+
+
+#ifndef UA_MAP_MATCHER_H
+#define UA_MAP_MATCHER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <regex>
+#include <stdint.h>
+
+/** @class ua_map_matcher
+ *	@brief This class matches process variable names against the pattern rules of the mapping file
+ *
+ * Glob rules ('*' matches any sequence, '?' matches one character, '\' escapes the next character) are compiled into one
+ * automaton. Its states are the sets of rule positions which are still possible after a prefix of the name, and are created
+ * the first time a name reaches them. So a name is classified against all glob rules in one pass over its characters, and
+ * only the rules which matched are walked again to extract their captures. Regex rules (ECMAScript syntax) are checked one
+ * after the other.
+ *
+ * Every wildcard of a glob rule and every group of a regex rule is a capture, which can be inserted into a template by
+ * <substitute>. Capture 0 is the whole name.
+ *
+ * match() can be called from several threads, adding rules can not.
+ *
+ */
+class ua_map_matcher {
+public:
+        /** @brief A rule which matched a name
+         */
+        struct Match {
+                size_t rule;
+                std::vector<std::string> captures;
+        };
+
+        ua_map_matcher();
+
+        /** @brief Add a glob rule
+        *
+        * @param pattern The glob, it has to match the whole name
+        *
+        * @return Number of the rule, the rules are numbered in the order they are added
+        */
+        size_t addGlob(const std::string &pattern);
+
+        /** @brief Add a regex rule
+        *
+        * @param pattern The regular expression, it has to match the whole name
+        *
+        * @return Number of the rule
+        *
+        * @throws std::regex_error if the pattern is no valid regular expression, no rule is added then
+        */
+        size_t addRegex(const std::string &pattern);
+
+        /** @brief Number of all rules
+        */
+        size_t size() const;
+
+        /** @brief Find all rules which match the name
+        *
+        * @param name Name of the process variable
+        *
+        * @return The matching rules ordered by their number
+        */
+        std::vector<Match> match(const std::string &name) const;
+
+        /** @brief Check if any rule matches the name, without extracting the captures
+        *
+        * @param name Name of the process variable
+        *
+        * @return True if at least one rule matches
+        */
+        bool matchesAny(const std::string &name) const;
+
+        /** @brief Replace $0 to $9 in the template by the captures, $$ is a single $
+        *
+        * @param templateString String with placeholders, for example the rename attribute
+        * @param captures Captures of a match
+        *
+        * @return The template with all placeholders replaced, placeholders without capture are removed
+        */
+        static std::string substitute(const std::string &templateString, const std::vector<std::string> &captures);
+
+private:
+        enum TokenType {
+                TOKEN_LITERAL,
+                TOKEN_ANY,
+                TOKEN_STAR
+        };
+
+        struct Token {
+                TokenType type;
+                char literal;
+        };
+
+        struct GlobRule {
+                size_t rule;
+                std::vector<Token> tokens;
+                // Position of the rule start in the automaton, position i means the first i tokens are matched
+                uint32_t firstPosition;
+        };
+
+        struct RegexRule {
+                size_t rule;
+                std::regex expression;
+        };
+
+        struct State {
+                std::vector<uint32_t> positions;
+                // Glob rules (positions in globs) which match if the name ends in this state
+                std::vector<size_t> accepting;
+                // Next state for every character, -1 until it is first needed
+                std::vector<int32_t> next;
+        };
+
+        size_t ruleCount;
+        std::vector<GlobRule> globs;
+        std::vector<RegexRule> regexes;
+        // Automaton position -> glob rule
+        std::vector<size_t> positionRule;
+
+        // The states are created while names are matched
+        mutable std::mutex automatonMutex;
+        mutable std::vector<State> states;
+        mutable std::map<std::vector<uint32_t>, int32_t> stateIndex;
+
+        void resetAutomaton();
+        void closePositions(std::vector<uint32_t> &positions) const;
+        int32_t findState(std::vector<uint32_t> &positions) const;
+        int32_t step(int32_t state, unsigned char character) const;
+        std::vector<size_t> acceptingGlobs(const std::string &name) const;
+        bool captureGlob(const GlobRule &glob, const std::string &name, std::vector<std::string> &captures) const;
+};
+
+#endif // UA_MAP_MATCHER_H
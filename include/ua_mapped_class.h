@@ -87,6 +87,15 @@ public:
 	*/
 	UA_StatusCode ua_mapDataSources(void* srcClass, UA_DataSource_Map* map);
 	
+	/** @brief Write static values once into the nodes of this class, see <ua_callProxy_mapValues>
+	* 
+	* @param map	Contains the values of all nodes from the class
+	* @param scrClass Pointer to our class instance 
+	* 
+	* @return UA_StatusCode
+	*/
+	UA_StatusCode ua_mapValues(void* srcClass, UA_Value_Map* map);
+	
 	/** @brief Get the SourceTimeStamp from node in the OPC UA server
 	 * Virtual methode which returned Timestamp is setted into the node with the help of the proxy_callback.h
 	 * 
@@ -22,8 +22,16 @@
 #define UA_PROCESSVARIABLE_H
 
 #include "ua_mapped_class.h"
+#include "ua_write_batch.h"
+#include "ua_value_snapshot.h"
 #include "ChimeraTK/ControlSystemAdapter/ControlSystemPVManager.h"
+#include <atomic>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <typeinfo>
+
+#include <boost/make_shared.hpp>
 
 using namespace std;
 using namespace ChimeraTK;
@@ -42,15 +50,106 @@ private:
         string engineeringUnit;
         string description;
         UA_NodeId ownNodeId;
+        UA_NodeId valueNodeId;
 
         boost::shared_ptr<ControlSystemPVManager> csManager;
 
+        /* Handle of the process variable, resolved once during construction so that the read/write
+         * callbacks never have to look up namePV in the PV-Manager again */
+        ProcessVariable::SharedPtr processVariable;
+        /* Typed ProcessArray<T>::SharedPtr of processVariable, T is given by valueType */
+        boost::shared_ptr<void> processArray;
+        std::type_info const *valueType;
+        size_t arrayLength;
+        bool readable;
+        bool writeable;
 
-        /** @brief  This methode mapped all own nodes into the opcua server
+        /* Every update is published once as immutable <ua_value_snapshot<T>>, the pointer is only accessed with
+         * boost::atomic_load/atomic_store. These are not lock-free, boost guards the pointer copy with a spinlock from a
+         * small pool. The lock never covers copying a value, so readers do not wait for the writer of a large array.
+         * In zero-copy array mode reads lend this snapshot to the stack */
+        bool zeroCopyArrays;
+        boost::shared_ptr<const ua_value_snapshot_base> valueSnapshot;
+        std::atomic<uint64_t> snapshotVersion;
+
+        /* Snapshots lent to the stack during the current server iteration. A delayed server callback releases them
+         * once the iteration has sent its responses, it holds its own reference in case the process variable is deleted first */
+        struct ua_lent_snapshots {
+                std::vector<boost::shared_ptr<const void> > snapshots;
+                bool releaseScheduled;
+        };
+        boost::shared_ptr<ua_lent_snapshots> lentSnapshots;
+        static void releaseLentSnapshotsDelayed(UA_Server *server, void *data);
+
+        /** @brief  Resolve the process variable from the PV-Manager and cache its typed handle, value type, length and access flags
+        */
+        void resolveProcessVariable();
+        /** @brief  Resolve the process variable as ProcessArray<T> and select the matching <ua_typed_proxy>, if T is its value type
+        *
+        * @return True if T is the value type of the process variable
+        */
+        template<typename T> bool resolveAs();
+        /** @brief  Try to resolve the process variable as one of the given types, in order
+        *
+        * @return True if one of the types is the value type of the process variable
+        */
+        template<typename T, typename T2, typename... Ts> bool resolveAs();
+
+        /* Value proxies and type name, selected once by resolveAs() */
+        UA_StatusCode (*valueRead)(void *handle, const UA_NodeId nodeid, UA_Boolean includeSourceTimeStamp, const UA_NumericRange *range, UA_DataValue *value);
+        UA_StatusCode (*valueWrite)(void *handle, const UA_NodeId nodeid, const UA_Variant *data, const UA_NumericRange *range);
+        string typeName;
+        const UA_DataType *valueDataType;
+        bool zeroCopyCapable;
+
+        /* Update pump mode: a pump thread receives the process variable and publishes every update as valueSnapshot,
+         * the server thread only reads the published snapshot */
+        bool pumped;
+        void (ua_processvariable::*publishUpdate)();
+        /** @brief  Publish the received value of the ProcessArray<T> as new snapshot, called by the pump thread
+        */
+        template<typename T> void publishSnapshot();
+
+        /* Write batching: during a client WriteRequest written values stay in the buffer and are sent by writeBatch at its end,
+         * in atomic mode writeBackup holds the value before the request (boost::shared_ptr<std::vector<T>>) */
+        ua_write_batch *writeBatch;
+        bool batched;
+        boost::shared_ptr<void> writeBackup;
+        void (ua_processvariable::*finishBatch)(bool send);
+        /** @brief  Send the batched value, or restore the value before the batch
+        */
+        template<typename T> void finishBatchedWriteAs(bool send);
+
+        /** @brief  Map the read and write proxies of the process variable onto the Value node
         *
         * @return <UA_StatusCode>
         */
-        UA_StatusCode mapSelfToNamespace();
+        UA_StatusCode mapValueDataSource();
+
+        /** @brief  Get the timestamp of the last update which was received from the process variable
+        *
+        * @return UA_DateTime
+        */
+        UA_DateTime receivedTimeStamp();
+
+        /** @brief  Add a metadata string variable below this processvariable, the children of ctkProcessVariable are built by hand
+        *
+        * @param typeTemplateId Numeric id of the metadata variable in the model
+        * @param browseName BrowseName and DisplayName of the new variable
+        * @param value Value of the new variable
+        * @param onWrite Write hook for client writes, NULL if the variable is read only
+        *
+        * @return <UA_StatusCode>
+        */
+        UA_StatusCode addMetadataVariable(UA_UInt32 typeTemplateId, const char *browseName, const string &value,
+                                          void (*onWrite)(void *handle, const UA_NodeId nodeid, const UA_Variant *data, const UA_NumericRange *range));
+
+        /** @brief  Write a metadata string into the value of its node, if this processvariable is already mapped
+        *
+        * @param typeTemplateId Numeric id of the metadata variable in the model
+        * @param value New value of the node
+        */
+        void writeMetadata(UA_UInt32 typeTemplateId, const string &value);
 
 public:
         /** @brief Constructor from ua_processvaribale for generic creation
@@ -59,8 +158,9 @@ public:
         * @param basenodeid Parent NodeId from OPC UA information model to add a new UA_ObjectNode
         * @param namePV Name of the process variable from control-system-adapter, is needed to fetch the rigth process varibale from PV-Manager
         * @param csManager Provide the hole PVManager from control-system-adapter to map all processvariable to the OPC UA-Model
+        * @param mapToNamespace If false, the process variable is only resolved and its nodes are added later by <mapSelfToNamespace> or <bindToNamespace>
         */
-        ua_processvariable(UA_Server *server, UA_NodeId basenodeid, string namePV, boost::shared_ptr<ControlSystemPVManager> csManager);
+        ua_processvariable(UA_Server *server, UA_NodeId basenodeid, string namePV, boost::shared_ptr<ControlSystemPVManager> csManager, bool mapToNamespace = true);
 
         /** @brief Destructor for ua_processvariable
         *
@@ -94,22 +194,32 @@ public:
         */
         string getType();
 
-        /** @brief  Set engineering unit of processvariable
+        /** @brief  Set engineering unit of processvariable, the EngineeringUnit node is updated as well
         *
         * @param type Define the engineering unit of the processvariable
         */
         void setEngineeringUnit(string engineeringUnit);
+        /** @brief  Take over the engineering unit a client wrote, the write hook calls this after the value is in the node
+        *
+        * @param engineeringUnit The written engineering unit
+        */
+        void cacheEngineeringUnit(string engineeringUnit);
         /** @brief  Get engineering unit of processvariable
         *
         * @return <String> of engineering unit
         */
         string getEngineeringUnit();
 
-        /** @brief  Get description unit of processvariable
+        /** @brief  Set description of processvariable, the Description node is updated as well
         *
-        * @return <String> of description
+        * @param description Define the description of the processvariable
         */
         void setDescription(string description);
+        /** @brief  Take over the description a client wrote, the write hook calls this after the value is in the node
+        *
+        * @param description The written description
+        */
+        void cacheDescription(string description);
         /** @brief  Get description unit of processvariable
         *
         * @return <String> of description
@@ -122,50 +232,250 @@ public:
         */
         UA_NodeId getOwnNodeId();
 
-        #define CREATE_READ_FUNCTION_ARRAY_DEF(_p_type)  std::vector<_p_type>  getValue_Array_##_p_type();
-        #define CREATE_WRITE_FUNCTION_ARRAY_DEF(_p_type) void setValue_Array_##_p_type(std::vector<_p_type> value);
-        #define CREATE_READ_FUNCTION_DEF(_p_type)  _p_type  getValue_##_p_type();
-        #define CREATE_WRITE_FUNCTION_DEF(_p_type) void setValue_##_p_type(_p_type value);
-
-    CREATE_WRITE_FUNCTION_DEF(int8_t)
-    CREATE_WRITE_FUNCTION_DEF(uint8_t)
-    CREATE_WRITE_FUNCTION_DEF(int16_t)
-    CREATE_WRITE_FUNCTION_DEF(uint16_t)
-    CREATE_WRITE_FUNCTION_DEF(int32_t)
-    CREATE_WRITE_FUNCTION_DEF(uint32_t)
-    CREATE_WRITE_FUNCTION_DEF(float)
-    CREATE_WRITE_FUNCTION_DEF(double)
-    CREATE_WRITE_FUNCTION_DEF(string)
-
-    CREATE_READ_FUNCTION_DEF(int8_t)
-    CREATE_READ_FUNCTION_DEF(uint8_t)
-    CREATE_READ_FUNCTION_DEF(int16_t)
-    CREATE_READ_FUNCTION_DEF(uint16_t)
-    CREATE_READ_FUNCTION_DEF(int32_t)
-    CREATE_READ_FUNCTION_DEF(uint32_t)
-    CREATE_READ_FUNCTION_DEF(float)
-    CREATE_READ_FUNCTION_DEF(double)
-    CREATE_READ_FUNCTION_DEF(string)
-
-    CREATE_WRITE_FUNCTION_ARRAY_DEF(int8_t)
-    CREATE_WRITE_FUNCTION_ARRAY_DEF(uint8_t)
-    CREATE_WRITE_FUNCTION_ARRAY_DEF(int16_t)
-    CREATE_WRITE_FUNCTION_ARRAY_DEF(uint16_t)
-    CREATE_WRITE_FUNCTION_ARRAY_DEF(int32_t)
-    CREATE_WRITE_FUNCTION_ARRAY_DEF(uint32_t)
-    CREATE_WRITE_FUNCTION_ARRAY_DEF(float)
-    CREATE_WRITE_FUNCTION_ARRAY_DEF(double)
-    CREATE_WRITE_FUNCTION_ARRAY_DEF(string)
-
-    CREATE_READ_FUNCTION_ARRAY_DEF(int8_t)
-    CREATE_READ_FUNCTION_ARRAY_DEF(uint8_t)
-    CREATE_READ_FUNCTION_ARRAY_DEF(int16_t)
-    CREATE_READ_FUNCTION_ARRAY_DEF(uint16_t)
-    CREATE_READ_FUNCTION_ARRAY_DEF(int32_t)
-    CREATE_READ_FUNCTION_ARRAY_DEF(uint32_t)
-    CREATE_READ_FUNCTION_ARRAY_DEF(float)
-    CREATE_READ_FUNCTION_ARRAY_DEF(double)
-    CREATE_READ_FUNCTION_ARRAY_DEF(string)
+        /** @brief  Enable or disable zero-copy array reads
+        *
+        * If enabled, array reads hand a non-owning variant into an immutable snapshot of the last update to the stack instead of copying the array.
+        * Only numeric arrays support this mode, for all other process variables the setting is ignored.
+        *
+        * @param enable Enable zero-copy array reads
+        */
+        void setZeroCopyArrays(bool enable);
+        /** @brief  Check if zero-copy array reads are enabled
+        *
+        * @return True if array reads are served from snapshots
+        */
+        bool isZeroCopyArrays();
+
+        /** @brief  Keep a snapshot alive until the stack has finished encoding the current response
+        *
+        * @param snapshot Snapshot which is borrowed by a UA_Variant
+        */
+        void lendSnapshot(boost::shared_ptr<const void> snapshot);
+        /** @brief  Release all snapshots lent to the stack, this is done by a delayed server callback after every iteration which lent one
+        */
+        void releaseLentSnapshots();
+
+        /** @brief  Hand the receiving of this process variable over to an update pump
+        *
+        * Afterwards only the pump thread receives the process variable and publishes every update via publishReceivedValue(), reads are served from the published value.
+        * Only process variables which are readable but not writeable can be pumped.
+        *
+        * @return True if the process variable is pumped now
+        */
+        bool enableUpdatePump();
+        /** @brief  Check if the process variable is received by an update pump
+        *
+        * @return True if reads are served from the value published by the pump
+        */
+        bool isPumped();
+        /** @brief  Publish the value received by the update pump, has to be called by the pump thread after receiving
+        */
+        void publishReceivedValue();
+        /** @brief  Sample all monitored items of the value node right away, has to be called by the server thread after publishReceivedValue()
+        */
+        void notifyMonitoredItems();
+        /** @brief  Set the minimum sampling interval of the value node, monitored items sample it at most that often
+        *
+        * Used for pumped process variables, whose value changes are pushed into the monitored items by notifyMonitoredItems().
+        *
+        * @param interval Minimum sampling interval in ms
+        */
+        void setFallbackSamplingInterval(UA_Double interval);
+        /** @brief  Set the deadband of the value node, applied to monitored items whose client requests no deadband of its own
+        *
+        * @param deadbandType UA_DEADBANDTYPE_ABSOLUTE or UA_DEADBANDTYPE_PERCENT, percent is relative to the last reported value and not to an EURange
+        * @param deadbandValue Width of the deadband
+        *
+        * @return UA_STATUSCODE_GOOD if the deadband is valid and set
+        */
+        UA_StatusCode setDeadband(UA_DeadbandType deadbandType, UA_Double deadbandValue);
+
+        /** @brief  Collect writes of client WriteRequests in the given batch
+        *
+        * @param writeBatch The batch, or nullptr to send every write immediately
+        */
+        void setWriteBatch(ua_write_batch *writeBatch);
+        /** @brief  Finish the write batch this process variable joined, called by <ua_write_batch> at the end of the request
+        *
+        * @param send True to send the batched value, false to restore the value before the request
+        */
+        void finishBatchedWrite(bool send);
+
+        /** @brief  This methode mapped all own nodes into the opcua server
+        *
+        * @return <UA_StatusCode>
+        */
+        UA_StatusCode mapSelfToNamespace();
+
+        /** @brief  Bind to the nodes of a processvariable object which were restored from a snapshot, instead of adding them
+        *
+        * The write hooks of the metadata and the data source of the Value node are attached again.
+        *
+        * @param objectNodeId Node id of the restored ctkProcessVariable object
+        *
+        * @return <UA_StatusCode>
+        */
+        UA_StatusCode bindToNamespace(const UA_NodeId &objectNodeId);
+
+        /** @brief  Get the node ids of all nodes owned by this processvariable, they stay valid as long as this instance exists
+        *
+        * @return The object node and its children
+        */
+        vector<UA_NodeId> getOwnedNodeIds();
+
+        /** @brief  Get the process variable of the PV-Manager which is represented by this instance
+        *
+        * @return The process variable
+        */
+        ProcessVariable::SharedPtr getProcessVariable();
+
+        /** @brief  Get the number of elements of the process variable
+        *
+        * @return Number of elements, 1 for scalar process variables
+        */
+        size_t getArrayLength();
+
+        /** @brief  Get the current value of the process variable, after all pending updates were received
+        *
+        * The caller has to make sure that T is the value type of the process variable. This is used by <ua_typed_proxy>, which is selected for the matching type only.
+        *
+        * @return Reference to the value buffer of the process variable
+        */
+        template<typename T> const std::vector<T> &readCurrentValue() {
+                ProcessArray<T> *processArray = static_cast<ProcessArray<T> *>(this->processArray.get());
+                if(this->readable) {
+                        while(processArray->readNonBlocking()) {}
+                }
+                return processArray->accessChannel(0);
+        }
+        /** @brief  Get an immutable snapshot of the current value, a new snapshot is only published if the process variable received an update or was written
+        *
+        * The caller has to make sure that T is the value type of the process variable.
+        *
+        * @return Shared snapshot of the current value with its source timestamp
+        */
+        template<typename T> boost::shared_ptr<const ua_value_snapshot<T> > readSnapshot() {
+                if(this->pumped) {
+                        return boost::static_pointer_cast<const ua_value_snapshot<T> >(boost::atomic_load(&this->valueSnapshot));
+                }
+                ProcessArray<T> *processArray = static_cast<ProcessArray<T> *>(this->processArray.get());
+                bool updated = false;
+                if(this->readable) {
+                        while(processArray->readNonBlocking()) { updated = true; }
+                }
+                boost::shared_ptr<const ua_value_snapshot_base> snapshot = boost::atomic_load(&this->valueSnapshot);
+                if(updated || !snapshot) {
+                        snapshot = boost::make_shared<const ua_value_snapshot<T> >(processArray->accessChannel(0), this->receivedTimeStamp(), ++this->snapshotVersion);
+                        boost::atomic_store(&this->valueSnapshot, snapshot);
+                }
+                return boost::static_pointer_cast<const ua_value_snapshot<T> >(snapshot);
+        }
+        /** @brief  Replace the value of the process variable and send it, missing elements are set to the default value of T
+        *
+        * The caller has to make sure that T is the value type and that the process variable is writeable.
+        *
+        * @param value New value
+        */
+        template<typename T> void writeCurrentValue(std::vector<T> value) {
+                ProcessArray<T> *processArray = static_cast<ProcessArray<T> *>(this->processArray.get());
+                value.resize(this->arrayLength);
+                processArray->accessChannel(0).swap(value);
+                processArray->write();
+                boost::atomic_store(&this->valueSnapshot, boost::shared_ptr<const ua_value_snapshot_base>());
+        }
+        /** @brief  Get the value buffer of the process variable to modify it in place, all elements hold their latest value
+        *
+        * The caller has to make sure that T is the value type and that the process variable is writeable. The modified value is sent by commitWrite<T>().
+        *
+        * @return Reference to the value buffer of the process variable, its size is the array length
+        */
+        template<typename T> std::vector<T> &writeBuffer() {
+                ProcessArray<T> *processArray = static_cast<ProcessArray<T> *>(this->processArray.get());
+                if(this->readable) {
+                        while(processArray->readNonBlocking()) {}
+                }
+                if(this->writeBatch != nullptr && this->writeBatch->isActive()) {
+                        if(!this->batched) {
+                                if(this->writeBatch->isAtomic()) {
+                                        this->writeBackup = boost::make_shared<std::vector<T> >(processArray->accessChannel(0));
+                                }
+                                this->batched = true;
+                                this->writeBatch->add(this);
+                        }
+                        this->writeBatch->deferWrite();
+                }
+                return processArray->accessChannel(0);
+        }
+        /** @brief  Send the value modified in writeBuffer<T>(), deferred to the end of the request if the process variable joined a write batch
+        */
+        template<typename T> void commitWrite() {
+                if(this->batched) return;
+                ProcessArray<T> *processArray = static_cast<ProcessArray<T> *>(this->processArray.get());
+                processArray->write();
+                boost::atomic_store(&this->valueSnapshot, boost::shared_ptr<const ua_value_snapshot_base>());
+        }
+
+        /** @brief  Get the scalar value of the process variable
+        *
+        * @return The value, or the default value of T if T is not the value type or the process variable is an array
+        */
+        template<typename T> T getValue() {
+                if(*this->valueType != typeid(T) || this->arrayLength != 1) return T();
+                if(this->pumped) return this->readSnapshot<T>()->value[0];
+                return this->readCurrentValue<T>()[0];
+        }
+        /** @brief  Set the scalar value of the process variable, ignored if T is not the value type, the process variable is an array or not writeable
+        *
+        * @param value New value
+        */
+        template<typename T> void setValue(T value) {
+                if(*this->valueType != typeid(T) || this->arrayLength != 1 || !this->writeable) return;
+                this->writeCurrentValue<T>(std::vector<T>(1, value));
+        }
+        /** @brief  Get the array value of the process variable
+        *
+        * @return Copy of the array, empty if T is not the value type or the process variable is a scalar
+        */
+        template<typename T> std::vector<T> getValue_Array() {
+                if(*this->valueType != typeid(T) || this->arrayLength <= 1) return std::vector<T>();
+                if(this->pumped) return this->readSnapshot<T>()->value;
+                return this->readCurrentValue<T>();
+        }
+        /** @brief  Set the array value of the process variable, ignored if T is not the value type, the process variable is a scalar or not writeable
+        *
+        * @param value New value, it is cut or padded to the length of the process variable
+        */
+        template<typename T> void setValue_Array(std::vector<T> value) {
+                if(*this->valueType != typeid(T) || this->arrayLength <= 1 || !this->writeable) return;
+                this->writeCurrentValue<T>(value);
+        }
+        /** @brief  Get an immutable snapshot of the array value
+        *
+        * @return Shared snapshot, empty if T is not the value type
+        */
+        template<typename T> boost::shared_ptr<const std::vector<T> > getSnapshot_Array() {
+                if(*this->valueType != typeid(T)) return boost::make_shared<const std::vector<T> >();
+                boost::shared_ptr<const ua_value_snapshot<T> > snapshot = this->readSnapshot<T>();
+                return boost::shared_ptr<const std::vector<T> >(snapshot, &snapshot->value);
+        }
+
+        /* Typed accessors of the value, e.g. getValue_int8_t() */
+        #define UA_PROCESSVARIABLE_ACCESSORS(_p_type) \
+        _p_type getValue_##_p_type() { return this->getValue<_p_type>(); } \
+        void setValue_##_p_type(_p_type value) { this->setValue<_p_type>(value); } \
+        std::vector<_p_type> getValue_Array_##_p_type() { return this->getValue_Array<_p_type>(); } \
+        void setValue_Array_##_p_type(std::vector<_p_type> value) { this->setValue_Array<_p_type>(value); } \
+        boost::shared_ptr<const std::vector<_p_type> > getSnapshot_Array_##_p_type() { return this->getSnapshot_Array<_p_type>(); }
+
+    UA_PROCESSVARIABLE_ACCESSORS(int8_t)
+    UA_PROCESSVARIABLE_ACCESSORS(uint8_t)
+    UA_PROCESSVARIABLE_ACCESSORS(int16_t)
+    UA_PROCESSVARIABLE_ACCESSORS(uint16_t)
+    UA_PROCESSVARIABLE_ACCESSORS(int32_t)
+    UA_PROCESSVARIABLE_ACCESSORS(uint32_t)
+    UA_PROCESSVARIABLE_ACCESSORS(float)
+    UA_PROCESSVARIABLE_ACCESSORS(double)
+    UA_PROCESSVARIABLE_ACCESSORS(string)
 };
 
 #endif // UA_PROCESSVARIABLE_H
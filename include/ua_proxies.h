@@ -13,6 +13,8 @@
 
 #include "open62541.h"
 #include <list>
+#include <vector>
+#include <unordered_map>
 #include <iostream>
 
 #include "ua_proxies_typeconversion.h"
@@ -29,7 +31,75 @@ typedef struct UA_NodeId_pair_t {
   UA_NodeId sourceNodeId;	// Model NodeId
   UA_NodeId targetNodeId;	// Stack NodeId
 } UA_NodeId_pair;
-typedef std::list<UA_NodeId_pair*> nodePairList;
+
+/**
+ * @struct UA_NodeId_hasher
+ * @brief Hash functor to key unordered containers by <UA_NodeId>, uses the hash of the open62541 nodestore
+ *
+ */
+struct UA_NodeId_hasher {
+  size_t operator()(const UA_NodeId &nodeId) const {
+    return UA_NodeId_hash(&nodeId);
+  }
+};
+
+/**
+ * @struct UA_NodeId_equalTo
+ * @brief Equality functor to key unordered containers by <UA_NodeId>
+ *
+ */
+struct UA_NodeId_equalTo {
+  bool operator()(const UA_NodeId &a, const UA_NodeId &b) const {
+    return UA_NodeId_equal(&a, &b) == UA_TRUE;
+  }
+};
+
+/**
+ * @class nodePairList
+ * @brief Flat list of <UA_NodeId_pair> in order of insertion, indexed by the model NodeId
+ *
+ * The pairs are stored by value and own deep copies of their NodeIds. Lookups by the model NodeId use a hash index and do not allocate.
+ * Multiple pairs may share a model NodeId, lookups return the first one that was pushed.
+ */
+class nodePairList {
+private:
+  std::vector<UA_NodeId_pair> pairs;
+  // Model NodeId -> position in pairs; the keys are shallow copies of pairs[i].sourceNodeId
+  std::unordered_multimap<UA_NodeId, size_t, UA_NodeId_hasher, UA_NodeId_equalTo> sourceIndex;
+
+  void reindex();
+
+public:
+  typedef std::vector<UA_NodeId_pair>::const_iterator const_iterator;
+  typedef std::vector<UA_NodeId_pair>::const_reverse_iterator const_reverse_iterator;
+
+  nodePairList() {};
+  ~nodePairList();
+  nodePairList(const nodePairList&) = delete;
+  nodePairList& operator=(const nodePairList&) = delete;
+
+  /** @brief Append a copy of both NodeIds */
+  void push(const UA_NodeId &sourceNodeId, const UA_NodeId &targetNodeId);
+  /** @brief Remove all pairs pointing to the given stack NodeId */
+  void removeByTargetId(const UA_NodeId &targetNodeId);
+  void clear();
+
+  /** @brief Stack NodeId of the first pair with the given model NodeId, NULL if there is none */
+  const UA_NodeId *getTargetIdBySourceId(const UA_NodeId &sourceNodeId) const;
+  /** @brief Call f(targetNodeId) for every pair with the given model NodeId */
+  template<typename F> void forEachTargetId(const UA_NodeId &sourceNodeId, F f) const {
+    auto range = this->sourceIndex.equal_range(sourceNodeId);
+    for(auto i = range.first; i != range.second; ++i)
+      f(this->pairs[i->second].targetNodeId);
+  }
+
+  const_iterator begin() const { return this->pairs.begin(); }
+  const_iterator end() const { return this->pairs.end(); }
+  const_reverse_iterator rbegin() const { return this->pairs.rbegin(); }
+  const_reverse_iterator rend() const { return this->pairs.rend(); }
+  size_t size() const { return this->pairs.size(); }
+  bool empty() const { return this->pairs.empty(); }
+};
 
 /**
  * @struct UA_FunctionCall_InstanceLookupTable_Element_t
@@ -41,7 +111,8 @@ typedef struct UA_FunctionCall_InstanceLookupTable_Element_t {
     void              *classInstance;     // Object instance Id
     UA_NodeId         classObjectId;      // Method Id
 } UA_FunctionCall_InstanceLookupTable_Element;
-typedef std::list<UA_FunctionCall_InstanceLookupTable_Element*> UA_FunctionCall_InstanceLookUpTable;
+// Keyed by classObjectId; the table does not own the NodeIds, the registering instance has to keep them alive
+typedef std::unordered_map<UA_NodeId, UA_FunctionCall_InstanceLookupTable_Element, UA_NodeId_hasher, UA_NodeId_equalTo> UA_FunctionCall_InstanceLookUpTable;
 
 /**
  * @struct UA_DataSource_Map_Element_t
@@ -53,21 +124,30 @@ typedef struct UA_DataSource_Map_Element_t {
         UA_LocalizedText description; // individuell description for every variable
   UA_StatusCode (*read)(void *handle, const UA_NodeId nodeid, UA_Boolean includeSourceTimeStamp,const UA_NumericRange *range, UA_DataValue *value);
   UA_StatusCode (*write)(void *handle, const UA_NodeId nodeid, const UA_Variant *data, const UA_NumericRange *range);
+  const UA_DataType *dataType; // type of the value, NULL keeps DataType and ValueRank of the node
+  UA_Int32      valueRank;     // ValueRank of the value, see IEC 62541-3
 } UA_DataSource_Map_Element;
 typedef std::list<UA_DataSource_Map_Element> UA_DataSource_Map;
 
+/**
+ * @struct UA_Value_Map_Element_t
+ * @brief For static values, this struct contains the value that is written once into the node of the model. Nodes with an onWrite hook are writeable, the hook is called after every write.
+ *
+ */
+typedef struct UA_Value_Map_Element_t {
+  UA_NodeId     typeTemplateId;
+        UA_LocalizedText description; // individuell description for every variable
+  UA_Variant    value; // copied into the node, the map does not own it
+  void (*onWrite)(void *handle, const UA_NodeId nodeid, const UA_Variant *data, const UA_NumericRange *range);
+} UA_Value_Map_Element;
+typedef std::list<UA_Value_Map_Element> UA_Value_Map;
+
 
 #define NODE_PAIR_PUSH(_p_listname, _p_srcId, _p_targetId) do {\
-UA_NodeId_pair *tmp = new UA_NodeId_pair;\
-UA_NodeId_copy(&_p_srcId, &tmp->sourceNodeId);\
-UA_NodeId_copy(&_p_targetId, &tmp->targetNodeId);\
-_p_listname.push_back(tmp); } while (0);
+_p_listname.push(_p_srcId, _p_targetId); } while (0);
 
 #define PUSH_OWNED_NODEID(_p_nodeid) do {\
-UA_NodeId_pair * _p_nodeid##_tmp = new UA_NodeId_pair;\
-UA_NodeId_copy(&UA_NODEID_NULL, & _p_nodeid##_tmp->sourceNodeId);\
-UA_NodeId_copy(&_p_nodeid, & _p_nodeid##_tmp->targetNodeId);\
-this->ownedNodes.push_back(_p_nodeid##_tmp); } while(0);
+this->ownedNodes.push(UA_NODEID_NULL, _p_nodeid); } while(0);
 
 /**
  * @brief Searching for NodeId's in <pairList> with the same NodeId from <remoteId>
@@ -78,7 +158,7 @@ this->ownedNodes.push_back(_p_nodeid##_tmp); } while(0);
  * @return UA_NodeId from the found node
  *
  */
-UA_NodeId *nodePairList_getTargetIdBySourceId(nodePairList pairList, UA_NodeId remoteId);
+const UA_NodeId *nodePairList_getTargetIdBySourceId(const nodePairList &pairList, UA_NodeId remoteId);
 
 /**
  * @brief Node function and proxy mapping for new nodes
@@ -101,7 +181,33 @@ UA_StatusCode ua_mapInstantiatedNodes(UA_NodeId objectId, UA_NodeId definitionId
  *
  * @return UA_StatusCode
  */
-UA_StatusCode ua_callProxy_mapDataSources(UA_Server* server, nodePairList instantiatedNodesList, UA_DataSource_Map *map, void *srcClass);
+UA_StatusCode ua_callProxy_mapDataSources(UA_Server* server, const nodePairList &instantiatedNodesList, UA_DataSource_Map *map, void *srcClass);
+
+/**
+ * @brief This methode writes all values in sort of a <UA_Value_Map> from the called class once into the open62541 nodes
+ *
+ * Reads of these nodes are served by the stack without calling back into the class.
+ *
+ * @param server	This param provides the OPC UA server
+ * @param instantiatedNodesList Contains all instantiated nodes
+ * @param map	Contains the values of all nodes from the class
+ * @param scrClass Pointer to our class instance, passed to the onWrite hooks
+ *
+ * @return UA_StatusCode
+ */
+UA_StatusCode ua_callProxy_mapValues(UA_Server* server, const nodePairList &instantiatedNodesList, UA_Value_Map *map, void *srcClass);
+
+/**
+ * @brief Resolve a one dimensional <UA_NumericRange> into a slice of an array. A range exceeding the array is cut at its end.
+ *
+ * @param range Index range requested by the client
+ * @param arrayLength Number of elements in the array
+ * @param first First element of the slice
+ * @param count Number of elements in the slice
+ *
+ * @return UA_StatusCode UA_STATUSCODE_BADINDEXRANGEINVALID if the range is malformed, UA_STATUSCODE_BADINDEXRANGENODATA if it starts behind the array
+ */
+UA_StatusCode ua_numericRange_getSlice(const UA_NumericRange *range, size_t arrayLength, size_t *first, size_t *count);
 
 /* Instatiation NodeId gatherer Macro (because it's always the same...) */
 #define UA_INSTATIATIONCALLBACK(_p_lstName) \
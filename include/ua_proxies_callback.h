@@ -34,24 +34,24 @@
  */
 // Generate Call-Through functions as stack callbacks
 #define UA_CALLPROXY_NAME(_CLASS_P, _CLASS_F) ua_callproxy_##_CLASS_P##_##_CLASS_F
-//#define UA_CALLPROXY_TABLENAME(_CLASS_P, _CLASS_F) C_MACRO_CONCAT( UA_CALLPROXY_NAME(_CLASS_P,_CLASS_F) , _InstanceLookUpTable)
+#define UA_CALLPROXY_TABLENAME(_CLASS_P, _CLASS_F) C_MACRO_CONCAT( UA_CALLPROXY_NAME(_CLASS_P,_CLASS_F) , _InstanceLookUpTable)
 #define UA_CALLPROXY_TABLE(_CLASS_P, _CLASS_F) & UA_CALLPROXY_TABLENAME(_CLASS_P, _CLASS_F)
 
 #define UA_CALLPROXY(_CLASS_P, _CLASS_F) \
 UA_FunctionCall_InstanceLookUpTable UA_CALLPROXY_TABLENAME(_CLASS_P, _CLASS_F); \
 UA_StatusCode UA_CALLPROXY_NAME(_CLASS_P,_CLASS_F)(void *methodHandle, const UA_NodeId objectId, size_t inputSize, const UA_Variant *input, size_t outputSize, UA_Variant *output){ \
-  for (UA_FunctionCall_InstanceLookUpTable::iterator j=UA_CALLPROXY_TABLENAME(_CLASS_P, _CLASS_F).begin(); j != UA_CALLPROXY_TABLENAME(_CLASS_P, _CLASS_F).end(); j++) \
-    if(UA_NodeId_equal(&(*(j))->classObjectId, &objectId)) { \
-      _CLASS_P *theClass = static_cast<_CLASS_P *>( (*(j))->classInstance ); \
-      return theClass->_CLASS_F(inputSize, input, outputSize, output); \
-    } \
+  UA_FunctionCall_InstanceLookUpTable::const_iterator j = UA_CALLPROXY_TABLENAME(_CLASS_P, _CLASS_F).find(objectId); \
+  if (j != UA_CALLPROXY_TABLENAME(_CLASS_P, _CLASS_F).end()) { \
+    _CLASS_P *theClass = static_cast<_CLASS_P *>( j->second.classInstance ); \
+    return theClass->_CLASS_F(inputSize, input, outputSize, output); \
+  } \
   return UA_STATUSCODE_GOOD; \
 }
 
 /* Generators for Valuesource read callbacks
- * Anyone who finds a way to do this using templates gets a cookie!
  * These callbacks are passed as functions to open62541 dataValue variables for read operations. 
  * They invoke the appropriate getXY() function of the object passed as handle.
+ * Process variable values are proxied by the templates in ua_typed_proxy.h instead.
  */
 
 /* Prototype wrappers */
@@ -80,55 +80,6 @@ _p_class *thisObj = static_cast<_p_class *> (handle); \
 UA_StatusCode UA_WRPROXY_NAME(_p_class, _p_method) (void *handle, const UA_NodeId nodeid,const UA_Variant *data, const UA_NumericRange *range) {\
 _p_class *theClass = static_cast<_p_class *> (handle);
 
-// Generator for Simple Read bodies (type cast)
-#define UA_RDPROXY_SIMPLEBODY(_p_method, _p_ctype, _p_uatype) \
-_p_ctype ua_val = thisObj->_p_method(); \
-UA_Variant_setScalarCopy(&value->value, &ua_val, &UA_TYPES[_p_uatype]); \
-
-#define UA_WRPROXY_SIMPLEBODY(_p_method, _p_ctype) \
-_p_ctype value = (_p_ctype) *((_p_ctype *) data->data); \
-theClass->_p_method (value);
-
-#define UA_WRPROXY_SIMPLEBODY_ARRAY(_p_method, _p_ctype) \
-_p_ctype* v = (_p_ctype *) data->data; \
-std::vector<_p_ctype> vectorizedValue(data->arrayLength); \
-for(uint32_t i=0; i < vectorizedValue.size(); i++) vectorizedValue.at(i) = v[i]; \
-theClass->_p_method(vectorizedValue); \
-
-#define UA_WRPROXY_SIMPLEBODY_ARRAY_STRING(_p_method, _p_ctype) \
-//UA_String* v = (UA_String*) data->data; \
-//std::vector<std::string> vectorizedValue(data->arrayLength); \
-//for(uint32_t i=0; i < vectorizedValue.size(); i++) { \
-//	std::string c_string; \
-//	UASTRING_TO_CPPSTRING(*v[i] , c_string); \
-//	vectorizedValue.at(i) = (std::string)c_string; \
-//} \
-//theClass->_p_method(vectorizedValue); \
-
-#define UA_RDPROXY_SIMPLEBODY_ARRAY(_p_method, _p_ctype, _p_uatype) \
-UA_Variant_setArrayCopy(&value->value, (_p_ctype *) thisObj->_p_method().data(), thisObj->_p_method().size(), &UA_TYPES[_p_uatype]); \
-UA_NumericRange arrayRange; \
-arrayRange.dimensionsSize = 1; \
-UA_NumericRangeDimension scalarThisDimension = (UA_NumericRangeDimension){.min = 0, .max = (unsigned)thisObj->_p_method().size()}; \
-arrayRange.dimensions = &scalarThisDimension; \
-UA_Variant_setRangeCopy(&value->value, (_p_ctype *) thisObj->_p_method().data(), thisObj->_p_method().size(), arrayRange); \
-
-#define UA_RDPROXY_SIMPLEBODY_ARRAY_STRING(_p_method, _p_ctype, _p_uatype) \
-//std::basic_string<char>* vectorizedValue; \
-//vectorizedValue = thisObj->_p_method().data(); \
-//UA_String ua_string_vector[thisObj->_p_method().size()]; \
-//for(uint32_t i=0; i < thisObj->_p_method().size(); i++) { \
-//	UA_String ua_val; \
-//	CPPSTRING_TO_UASTRING_NEW(ua_val, vectorizedValue); \
-//	ua_string_vector[i] = ua_val; \
-//} \
-//UA_Variant_setArrayCopy(&value->value, ua_string_vector, thisObj->_p_method().size(), &UA_TYPES[UA_TYPES_STRING]); \
-//UA_NumericRange arrayRange; \
-//arrayRange.dimensionsSize = 1; \
-//UA_NumericRangeDimension scalarThisDimension = (UA_NumericRangeDimension){.min = 0, .max = (unsigned)thisObj->_p_method().size()}; \
-//arrayRange.dimensions = &scalarThisDimension; \
-//UA_Variant_setRangeCopy(&value->value, (_p_ctype *) thisObj->_p_method().data(), thisObj->_p_method().size(), arrayRange); \
-
 // Typed Function Protoypes with datatype specific stuff
 // Readproxies:
 #define UA_RDPROXY_STRING(_p_class, _p_method) \
@@ -151,106 +102,6 @@ UA_Variant_setScalarCopy(&value->value, &ua_val, &UA_TYPES[UA_TYPES_LOCALIZEDTEX
 UA_LocalizedText_deleteMembers(&ua_val); \
 UA_RDPROXY_TAIL()
 
-#define UA_RDPROXY_INT32(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY(_p_method, int32_t, UA_TYPES_INT32); \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_UINT32(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY(_p_method, uint32_t, UA_TYPES_UINT32); \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_INT16(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY(_p_method, int16_t, UA_TYPES_INT16); \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_UINT16(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY(_p_method, uint16_t, UA_TYPES_UINT16); \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_INT8(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY(_p_method, int8_t, UA_TYPES_SBYTE); \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_UINT8(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY(_p_method, uint8_t, UA_TYPES_BYTE); \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_BOOL(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY(_p_method, UA_Boolean, UA_TYPES_BOOLEAN); \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_FLOAT(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY(_p_method, float, UA_TYPES_FLOAT); \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_DOUBLE(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY(_p_method, double, UA_TYPES_DOUBLE); \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_DATETIME(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY(_p_method, long long int, UA_TYPES_DATETIME); \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_NODEID(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY(_p_method, UA_NodeId, UA_TYPES_NODEID); \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_ARRAY_INT8(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY_ARRAY(_p_method, int8_t, UA_TYPES_SBYTE) \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_ARRAY_UINT8(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY_ARRAY(_p_method, uint8_t, UA_TYPES_BYTE) \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_ARRAY_INT16(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY_ARRAY(_p_method, int16_t, UA_TYPES_INT16) \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_ARRAY_UINT16(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY_ARRAY(_p_method, uint16_t, UA_TYPES_UINT16) \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_ARRAY_INT32(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY_ARRAY(_p_method, int32_t, UA_TYPES_INT32) \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_ARRAY_UINT32(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY_ARRAY(_p_method, uint32_t, UA_TYPES_UINT32) \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_ARRAY_FLOAT(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY_ARRAY(_p_method, float, UA_TYPES_FLOAT) \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_ARRAY_DOUBLE(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY_ARRAY(_p_method, double, UA_TYPES_DOUBLE) \
-UA_RDPROXY_TAIL()
-
-#define UA_RDPROXY_ARRAY_STRING(_p_class, _p_method) \
-UA_RDPROXY_HEAD(_p_class, _p_method) \
-UA_RDPROXY_SIMPLEBODY_ARRAY_STRING(_p_method, string, UA_TYPES_STRING) \
-UA_RDPROXY_TAIL()
-
 // Writeproxies:
 #define UA_WRPROXY_STRING(_p_class, _p_method) \
 UA_WRPROXY_HEAD(_p_class, _p_method) \
@@ -268,104 +119,17 @@ UASTRING_TO_CPPSTRING( ((UA_String) *((UA_String *) &((UA_LocalizedText *) data-
 theClass->_p_method(std::make_tuple(locale, text)); \
 UA_WRPROXY_TAIL()
 
-#define UA_WRPROXY_INT8(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY(_p_method, uint32_t); \
-UA_WRPROXY_TAIL()
-
-#define UA_WRPROXY_UINT8(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY(_p_method, uint32_t); \
-UA_WRPROXY_TAIL()
-
-#define UA_WRPROXY_INT16(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY(_p_method, uint32_t); \
-UA_WRPROXY_TAIL()
-
-#define UA_WRPROXY_UINT16(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY(_p_method, uint32_t); \
-UA_WRPROXY_TAIL()
-
-#define UA_WRPROXY_INT32(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY(_p_method, uint32_t); \
-UA_WRPROXY_TAIL()
-
-#define UA_WRPROXY_UINT32(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY(_p_method, uint32_t); \
-UA_WRPROXY_TAIL()
-    
-#define UA_WRPROXY_BOOL(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY(_p_method, bool); \
-UA_WRPROXY_TAIL()
-    
-#define UA_WRPROXY_FLOAT(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY(_p_method, float); \
-UA_WRPROXY_TAIL()
-
-#define UA_WRPROXY_DOUBLE(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY(_p_method, double); \
-UA_WRPROXY_TAIL()
-
-#define UA_WRPROXY_DATETIME(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY(_p_method, UA_DateTime); \
-UA_WRPROXY_TAIL()
-
-#define UA_WRPROXY_NODEID(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY(_p_method, UA_NodeId); \
-UA_WRPROXY_TAIL()
-
-#define UA_WRPROXY_ARRAY_INT8(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY_ARRAY(_p_method, int8_t)\
-UA_WRPROXY_TAIL()
-
-#define UA_WRPROXY_ARRAY_UINT8(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY_ARRAY(_p_method, uint8_t)\
-UA_WRPROXY_TAIL()
-
-#define UA_WRPROXY_ARRAY_INT16(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY_ARRAY(_p_method, int16_t)\
-UA_WRPROXY_TAIL()
-
-#define UA_WRPROXY_ARRAY_UINT16(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY_ARRAY(_p_method, uint16_t)\
-UA_WRPROXY_TAIL()
-
-#define UA_WRPROXY_ARRAY_INT32(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY_ARRAY(_p_method, int32_t)\
-UA_WRPROXY_TAIL()
-
-#define UA_WRPROXY_ARRAY_UINT32(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY_ARRAY(_p_method, uint32_t)\
-UA_WRPROXY_TAIL()
-
-#define UA_WRPROXY_ARRAY_FLOAT(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY_ARRAY(_p_method, float)\
-UA_WRPROXY_TAIL()
-
-#define UA_WRPROXY_ARRAY_DOUBLE(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY_ARRAY(_p_method, double)\
-UA_WRPROXY_TAIL()
+/* Generators for value write hooks
+ * Static values are written once into their nodes, writes of clients are passed to the setXY() function of the object passed as handle afterwards.
+ */
+#define UA_WRHOOK_NAME(_p_class, _p_method) ua_writehook_ ##_p_class## _ ##_p_method
 
-#define UA_WRPROXY_ARRAY_STRING(_p_class, _p_method) \
-UA_WRPROXY_HEAD(_p_class, _p_method) \
-UA_WRPROXY_SIMPLEBODY_ARRAY_STRING(_p_method, _p_ctype) \
-UA_WRPROXY_TAIL()
+#define UA_WRHOOK_STRING(_p_class, _p_method) \
+void UA_WRHOOK_NAME(_p_class, _p_method) (void *handle, const UA_NodeId nodeid, const UA_Variant *data, const UA_NumericRange *range) { \
+if (range != NULL || !UA_Variant_hasScalarType(data, &UA_TYPES[UA_TYPES_STRING])) return; \
+_p_class *theClass = static_cast<_p_class *> (handle); \
+std::string cpps; \
+UASTRING_TO_CPPSTRING( ((UA_String) *((UA_String *) data->data)) , cpps); \
+theClass->_p_method(cpps); }
 
 #endif //HAVE_UA_PROXIES_CALLBACK_H
@@ -0,0 +1,283 @@
+/*
+ * This file is part of ChimeraTKs ControlSystem-OPC-UA-Adapter.
+ *
+ * ChimeraTKs ControlSystem-OPC-UA-Adapter is free software: you can
+ * redistribute it and/or modify it under the terms of the Lesser GNU
+ * General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ChimeraTKs ControlSystem-OPC-UA-Adapter is distributed in the hope
+ * that it will be useful, but WITHOUT ANY WARRANTY; without even the
+ * implied warranty ofMERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Foobar.  If not, see https://www.gnu.org/licenses/lgpl.html
+ *
+ * Copyright (c) 2016 Chris Iatrou <Chris_Paul.Iatrou@tu-dresden.de>
+ * Copyright (c) 2016 Julian Rahm  <Julian.Rahm@tu-dresden.de>
+ */
+
+#ifndef HAVE_UA_TYPED_PROXY_H
+#define HAVE_UA_TYPED_PROXY_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+extern "C" {
+#include "open62541.h"
+}
+
+#include "ua_proxies.h"
+#include "ua_value_snapshot.h"
+
+/* Compile time mapping of C++ value types to the open62541 type table.
+ * Every supported type provides:
+ *  typeIndex  Index into UA_TYPES
+ *  zeroCopy   True if std::vector<T> stores its elements exactly like an UA array of typeIndex
+ *  typeName() Name reported by the "Type" variable of a process variable
+ *  toScalar() / toArray() Conversion of C++ values into UA_Variants
+ *  fromVariant() Copy count elements of an UA_Variant into an existing buffer, starting at index first
+ */
+template<typename T> struct ua_type_traits;
+
+/* Traits for types which have the same memory layout in C++ and in open62541 */
+template<typename T, UA_UInt16 _typeIndex>
+struct ua_plain_type_traits {
+	static constexpr UA_UInt16 typeIndex = _typeIndex;
+	static constexpr bool zeroCopy = true;
+
+	static UA_StatusCode toScalar(UA_Variant *variant, const T &value) {
+		return UA_Variant_setScalarCopy(variant, &value, &UA_TYPES[typeIndex]);
+	}
+	static UA_StatusCode toArray(UA_Variant *variant, const std::vector<T> &value, size_t first, size_t count) {
+		return UA_Variant_setArrayCopy(variant, value.data() + first, count, &UA_TYPES[typeIndex]);
+	}
+	static void fromVariant(const UA_Variant *variant, size_t count, std::vector<T> &value, size_t first) {
+		std::memcpy(value.data() + first, variant->data, count * sizeof(T));
+	}
+};
+
+#define UA_PLAIN_TYPE_TRAITS(_p_ctype, _p_uatype) \
+template<> struct ua_type_traits<_p_ctype> : ua_plain_type_traits<_p_ctype, _p_uatype> { \
+	static const char *typeName() { return #_p_ctype; } \
+};
+
+UA_PLAIN_TYPE_TRAITS(int8_t,   UA_TYPES_SBYTE)
+UA_PLAIN_TYPE_TRAITS(uint8_t,  UA_TYPES_BYTE)
+UA_PLAIN_TYPE_TRAITS(int16_t,  UA_TYPES_INT16)
+UA_PLAIN_TYPE_TRAITS(uint16_t, UA_TYPES_UINT16)
+UA_PLAIN_TYPE_TRAITS(int32_t,  UA_TYPES_INT32)
+UA_PLAIN_TYPE_TRAITS(uint32_t, UA_TYPES_UINT32)
+UA_PLAIN_TYPE_TRAITS(int64_t,  UA_TYPES_INT64)
+UA_PLAIN_TYPE_TRAITS(uint64_t, UA_TYPES_UINT64)
+UA_PLAIN_TYPE_TRAITS(float,    UA_TYPES_FLOAT)
+UA_PLAIN_TYPE_TRAITS(double,   UA_TYPES_DOUBLE)
+
+/* std::vector<bool> is packed, so every element has to be converted on its own */
+template<> struct ua_type_traits<bool> {
+	static constexpr UA_UInt16 typeIndex = UA_TYPES_BOOLEAN;
+	static constexpr bool zeroCopy = false;
+	static const char *typeName() { return "bool"; }
+
+	static UA_StatusCode toScalar(UA_Variant *variant, const bool &value) {
+		UA_Boolean uaValue = value;
+		return UA_Variant_setScalarCopy(variant, &uaValue, &UA_TYPES[typeIndex]);
+	}
+	static UA_StatusCode toArray(UA_Variant *variant, const std::vector<bool> &value, size_t first, size_t count) {
+		UA_Boolean *data = static_cast<UA_Boolean *>(UA_Array_new(count, &UA_TYPES[typeIndex]));
+		if(!data && count > 0)
+			return UA_STATUSCODE_BADOUTOFMEMORY;
+		for(size_t i = 0; i < count; i++)
+			data[i] = value[first + i];
+		UA_Variant_setArray(variant, data, count, &UA_TYPES[typeIndex]);
+		return UA_STATUSCODE_GOOD;
+	}
+	static void fromVariant(const UA_Variant *variant, size_t count, std::vector<bool> &value, size_t first) {
+		const UA_Boolean *data = static_cast<const UA_Boolean *>(variant->data);
+		for(size_t i = 0; i < count; i++)
+			value[first + i] = data[i];
+	}
+};
+
+template<> struct ua_type_traits<std::string> {
+	static constexpr UA_UInt16 typeIndex = UA_TYPES_STRING;
+	static constexpr bool zeroCopy = false;
+	static const char *typeName() { return "string"; }
+
+	static UA_StatusCode toScalar(UA_Variant *variant, const std::string &value) {
+		UA_String uaValue;
+		uaValue.length = value.length();
+		uaValue.data = (UA_Byte *) value.data();
+		return UA_Variant_setScalarCopy(variant, &uaValue, &UA_TYPES[typeIndex]);
+	}
+	static UA_StatusCode toArray(UA_Variant *variant, const std::vector<std::string> &value, size_t first, size_t count) {
+		UA_String *data = static_cast<UA_String *>(UA_Array_new(count, &UA_TYPES[typeIndex]));
+		if(!data && count > 0)
+			return UA_STATUSCODE_BADOUTOFMEMORY;
+		UA_StatusCode retval = UA_STATUSCODE_GOOD;
+		for(size_t i = 0; i < count && retval == UA_STATUSCODE_GOOD; i++) {
+			UA_String element;
+			element.length = value[first + i].length();
+			element.data = (UA_Byte *) value[first + i].data();
+			retval = UA_String_copy(&element, &data[i]);
+		}
+		if(retval != UA_STATUSCODE_GOOD) {
+			UA_Array_delete(data, count, &UA_TYPES[typeIndex]);
+			return retval;
+		}
+		UA_Variant_setArray(variant, data, count, &UA_TYPES[typeIndex]);
+		return UA_STATUSCODE_GOOD;
+	}
+	static void fromVariant(const UA_Variant *variant, size_t count, std::vector<std::string> &value, size_t first) {
+		const UA_String *data = static_cast<const UA_String *>(variant->data);
+		for(size_t i = 0; i < count; i++)
+			value[first + i].assign((const char *) data[i].data, data[i].length);
+	}
+};
+
+/* Borrow the requested slice of an immutable snapshot, only possible if the memory layout matches */
+template<class C, typename T, bool zeroCopy = ua_type_traits<T>::zeroCopy>
+struct ua_typed_snapshot {
+	static UA_StatusCode borrow(C *thisObj, const UA_NumericRange *range, UA_Variant *variant, UA_DateTime *sourceTimeStamp) {
+		return UA_STATUSCODE_BADNOTSUPPORTED;
+	}
+};
+
+template<class C, typename T>
+struct ua_typed_snapshot<C, T, true> {
+	static UA_StatusCode borrow(C *thisObj, const UA_NumericRange *range, UA_Variant *variant, UA_DateTime *sourceTimeStamp) {
+		boost::shared_ptr<const ua_value_snapshot<T> > snapshot = thisObj->template readSnapshot<T>();
+		size_t first = 0;
+		size_t count = snapshot->value.size();
+		if(range) {
+			UA_StatusCode retval = ua_numericRange_getSlice(range, snapshot->value.size(), &first, &count);
+			if(retval != UA_STATUSCODE_GOOD)
+				return retval;
+		}
+		thisObj->lendSnapshot(snapshot);
+		UA_Variant_setArray(variant, (void *) (snapshot->value.data() + first), count, &UA_TYPES[ua_type_traits<T>::typeIndex]);
+		variant->storageType = UA_VARIANT_DATA_NODELETE;
+		*sourceTimeStamp = snapshot->sourceTimeStamp;
+		return UA_STATUSCODE_GOOD;
+	}
+};
+
+/** @struct ua_typed_proxy
+ *	@brief Data source callbacks for the value of class C with the C++ value type T
+ *
+ * The proxy is selected once, when the node is mapped into the server. Therefore the callbacks
+ * neither check the type nor the shape of the value again. C has to provide:
+ *  const std::vector<T> &readCurrentValue<T>()
+ *  boost::shared_ptr<const ua_value_snapshot<T> > readSnapshot<T>()
+ *  std::vector<T> &writeBuffer<T>(), void commitWrite<T>()
+ *  size_t getArrayLength(), bool isZeroCopyArrays(), bool isPumped(), void lendSnapshot(...), UA_DateTime getSourceTimeStamp()
+ * If C is pumped, values are only read from readSnapshot<T>(), which is published by another thread. The source timestamp
+ * is always taken from the same snapshot as the value.
+ * Writes check the variant once and copy it straight into writeBuffer<T>(), without an intermediate vector.
+ */
+template<class C, typename T>
+struct ua_typed_proxy {
+	typedef ua_type_traits<T> traits;
+
+	static UA_StatusCode finishRead(UA_DateTime sourceTimeStamp, UA_Boolean includeSourceTimeStamp, UA_DataValue *value) {
+		value->hasValue = UA_TRUE;
+		if(includeSourceTimeStamp) {
+			value->sourceTimestamp = sourceTimeStamp;
+			value->hasSourceTimestamp = UA_TRUE;
+		}
+		return UA_STATUSCODE_GOOD;
+	}
+
+	static UA_StatusCode copySlice(const std::vector<T> &current, const UA_NumericRange *range, UA_Variant *variant) {
+		size_t first = 0;
+		size_t count = current.size();
+		if(range) {
+			UA_StatusCode retval = ua_numericRange_getSlice(range, current.size(), &first, &count);
+			if(retval != UA_STATUSCODE_GOOD)
+				return retval;
+		}
+		return traits::toArray(variant, current, first, count);
+	}
+
+	static UA_StatusCode read(void *handle, const UA_NodeId nodeid, UA_Boolean includeSourceTimeStamp, const UA_NumericRange *range, UA_DataValue *value) {
+		C *thisObj = static_cast<C *>(handle);
+		UA_StatusCode retval;
+		UA_DateTime sourceTimeStamp;
+		if(thisObj->isPumped()) {
+			boost::shared_ptr<const ua_value_snapshot<T> > snapshot = thisObj->template readSnapshot<T>();
+			retval = traits::toScalar(&value->value, snapshot->value[0]);
+			sourceTimeStamp = snapshot->sourceTimeStamp;
+		}
+		else {
+			retval = traits::toScalar(&value->value, thisObj->template readCurrentValue<T>()[0]);
+			sourceTimeStamp = thisObj->getSourceTimeStamp();
+		}
+		if(retval != UA_STATUSCODE_GOOD)
+			return retval;
+		return finishRead(sourceTimeStamp, includeSourceTimeStamp, value);
+	}
+
+	static UA_StatusCode readArray(void *handle, const UA_NodeId nodeid, UA_Boolean includeSourceTimeStamp, const UA_NumericRange *range, UA_DataValue *value) {
+		C *thisObj = static_cast<C *>(handle);
+		UA_StatusCode retval = UA_STATUSCODE_GOOD;
+		UA_DateTime sourceTimeStamp = 0;
+		if(thisObj->isZeroCopyArrays()) {
+			retval = ua_typed_snapshot<C, T>::borrow(thisObj, range, &value->value, &sourceTimeStamp);
+		}
+		else if(thisObj->isPumped()) {
+			boost::shared_ptr<const ua_value_snapshot<T> > snapshot = thisObj->template readSnapshot<T>();
+			retval = copySlice(snapshot->value, range, &value->value);
+			sourceTimeStamp = snapshot->sourceTimeStamp;
+		}
+		else {
+			// Reference into the process array, only the requested slice is copied
+			retval = copySlice(thisObj->template readCurrentValue<T>(), range, &value->value);
+			sourceTimeStamp = thisObj->getSourceTimeStamp();
+		}
+		if(retval != UA_STATUSCODE_GOOD)
+			return retval;
+		return finishRead(sourceTimeStamp, includeSourceTimeStamp, value);
+	}
+
+	static UA_StatusCode write(void *handle, const UA_NodeId nodeid, const UA_Variant *data, const UA_NumericRange *range) {
+		C *thisObj = static_cast<C *>(handle);
+		if(data->type != &UA_TYPES[traits::typeIndex] || !data->data)
+			return UA_STATUSCODE_BADTYPEMISMATCH;
+		traits::fromVariant(data, 1, thisObj->template writeBuffer<T>(), 0);
+		thisObj->template commitWrite<T>();
+		return UA_STATUSCODE_GOOD;
+	}
+
+	static UA_StatusCode writeArray(void *handle, const UA_NodeId nodeid, const UA_Variant *data, const UA_NumericRange *range) {
+		C *thisObj = static_cast<C *>(handle);
+		if(data->type != &UA_TYPES[traits::typeIndex] || UA_Variant_isScalar(data))
+			return UA_STATUSCODE_BADTYPEMISMATCH;
+		size_t first = 0;
+		size_t count = thisObj->getArrayLength();
+		if(range) {
+			UA_StatusCode retval = ua_numericRange_getSlice(range, thisObj->getArrayLength(), &first, &count);
+			if(retval != UA_STATUSCODE_GOOD)
+				return retval;
+			if(count != data->arrayLength)
+				return UA_STATUSCODE_BADINDEXRANGEINVALID;
+		}
+		
+		std::vector<T> &buffer = thisObj->template writeBuffer<T>();
+		if(!range && data->arrayLength < count) {
+			// Shorter arrays are padded with the default value of T, longer ones are cut
+			std::fill(buffer.begin() + data->arrayLength, buffer.end(), T());
+			count = data->arrayLength;
+		}
+		traits::fromVariant(data, count, buffer, first);
+		thisObj->template commitWrite<T>();
+		return UA_STATUSCODE_GOOD;
+	}
+};
+
+#endif // HAVE_UA_TYPED_PROXY_H
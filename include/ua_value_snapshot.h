@@ -0,0 +1,56 @@
+/* 
+ * This file is part of ChimeraTKs ControlSystem-OPC-UA-Adapter.
+ *
+ * ChimeraTKs ControlSystem-OPC-UA-Adapter is free software: you can 
+ * redistribute it and/or modify it under the terms of the Lesser GNU 
+ * General Public License as published by the Free Software Foundation, 
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ChimeraTKs ControlSystem-OPC-UA-Adapter is distributed in the hope 
+ * that it will be useful, but WITHOUT ANY WARRANTY; without even the 
+ * implied warranty ofMERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+ * See the Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Foobar.  If not, see https://www.gnu.org/licenses/lgpl.html
+ * 
+ * Copyright (c) 2016 Chris Iatrou <Chris_Paul.Iatrou@tu-dresden.de>
+ * Copyright (c) 2016 Julian Rahm  <Julian.Rahm@tu-dresden.de>
+ */
+
+#ifndef UA_VALUE_SNAPSHOT_H
+#define UA_VALUE_SNAPSHOT_H
+
+#include <stdint.h>
+#include <vector>
+
+extern "C" {
+#include "open62541.h"
+}
+
+/** @struct ua_value_snapshot_base
+ *	@brief Type independent part of a <ua_value_snapshot>, the source timestamp and version of the value
+ */
+struct ua_value_snapshot_base {
+        UA_DateTime sourceTimeStamp;
+        uint64_t version;
+};
+
+/** @struct ua_value_snapshot
+ *	@brief Immutable value of a process variable together with the source timestamp and version it was published with
+ *
+ * Snapshots are published by swapping the pointer, so a reader always gets a value and timestamp of the same update.
+ * A sequence lock would let readers copy a std::vector while the writer replaces it, which is undefined behaviour and may
+ * follow a freed buffer. A snapshot is never modified, so it can be shared without copying it again.
+ */
+template<typename T>
+struct ua_value_snapshot : ua_value_snapshot_base {
+        std::vector<T> value;
+
+        ua_value_snapshot(const std::vector<T> &value, UA_DateTime sourceTimeStamp, uint64_t version) : value(value) {
+                this->sourceTimeStamp = sourceTimeStamp;
+                this->version = version;
+        }
+};
+
+#endif // UA_VALUE_SNAPSHOT_H
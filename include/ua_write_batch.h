@@ -0,0 +1,109 @@
+/* 
+ * This file is part of ChimeraTKs ControlSystem-OPC-UA-Adapter.
+ *
+ * ChimeraTKs ControlSystem-OPC-UA-Adapter is free software: you can 
+ * redistribute it and/or modify it under the terms of the Lesser GNU 
+ * General Public License as published by the Free Software Foundation, 
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ChimeraTKs ControlSystem-OPC-UA-Adapter is distributed in the hope 
+ * that it will be useful, but WITHOUT ANY WARRANTY; without even the 
+ * implied warranty ofMERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+ * See the Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Foobar.  If not, see https://www.gnu.org/licenses/lgpl.html
+ * 
+ * Copyright (c) 2016 Chris Iatrou <Chris_Paul.Iatrou@tu-dresden.de>
+ * Copyright (c) 2016 Julian Rahm  <Julian.Rahm@tu-dresden.de>
+ */
+
+#ifndef UA_WRITE_BATCH_H
+#define UA_WRITE_BATCH_H
+
+#include <vector>
+
+extern "C" {
+#include "open62541.h"
+}
+
+class ua_processvariable;
+
+/** @class ua_write_batch
+ *	@brief This class collects the process variable writes of one client WriteRequest and sends them together at its end
+ *
+ * The batch is registered as UA_WriteRequestCallback of the server. While a WriteRequest is processed, written process variables
+ * only modify their buffer and join the batch. At the end of the request every joined process variable is sent once, so the
+ * application receives the whole parameter set at once. In atomic mode nothing is sent if any write of the request failed,
+ * and all joined process variables are restored. Writes of other nodes are not part of the batch, they are applied right away
+ * and keep their result.
+ *
+ * The batch is only used by the server thread.
+ *
+ *  @author Chris Iatrou, Julian Rahm
+ *  @date 22.11.2016
+ *
+ */
+class ua_write_batch {
+private:
+        bool atomic;
+        bool active;
+        std::vector<ua_processvariable *> pending;
+        size_t deferredWrites;
+
+public:
+        /** @brief Constructor of the class
+        *
+        * @param atomic True to send the writes of a request only if all of them succeeded
+        */
+        ua_write_batch(bool atomic = false);
+
+        /** @brief Register the batch as UA_WriteRequestCallback of the server
+        *
+        * @param server The opcua server
+        */
+        void attach(UA_Server *server);
+
+        /** @brief Set the all-or-nothing mode, which applies from the next request on
+        *
+        * @param atomic True to send the writes of a request only if all of them succeeded
+        */
+        void setAtomic(bool atomic);
+        bool isAtomic();
+
+        /** @brief Start collecting writes
+        */
+        void begin();
+
+        /** @brief Check if writes are collected right now
+        *
+        * @return True between begin() and end()
+        */
+        bool isActive();
+
+        /** @brief Add a process variable which was written during the request, every process variable joins only once
+        *
+        * @param processvariable The written process variable
+        */
+        void add(ua_processvariable *processvariable);
+
+        /** @brief Count a write which is deferred to the end of the request, the server only reports these as abandoned
+        */
+        void deferWrite();
+
+        /** @brief Get the number of writes deferred since begin()
+        *
+        * @return Number of deferred writes
+        */
+        size_t getDeferredWrites();
+
+        /** @brief Send or discard all collected writes and stop collecting
+        *
+        * @param failed True if at least one write of the request failed
+        *
+        * @return UA_STATUSCODE_GOOD if the writes were sent, UA_STATUSCODE_BADOPERATIONABANDONED if they were discarded
+        */
+        UA_StatusCode end(bool failed);
+};
+
+#endif // UA_WRITE_BATCH_H
@@ -88,7 +88,7 @@ public:
 	* 
 	* @return Returns a vector of every single splitet word
 	*/
-	std::vector<std::string> praseVariablePath(std::string variablePath, std::string seperator = "/");
+	static std::vector<std::string> praseVariablePath(std::string variablePath, std::string seperator = "/");
 	
 	/** @brief This methode returns a value of the given attribute from the given node you want to know
 	* 
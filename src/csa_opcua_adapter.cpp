@@ -28,6 +28,7 @@ extern "C" {
 #include <math.h>
 #include <typeinfo>       // std::bad_cast
 
+#include "csa_config.h"
 #include "ipc_manager.h"
 #include "ua_adapter.h"
 #include "ua_processvariable.h"
@@ -42,6 +43,7 @@ csa_opcua_adapter::csa_opcua_adapter(boost::shared_ptr<ControlSystemPVManager> c
 	this->csManager = csManager; 	
 	this->csa_opcua_adapter_InitServer(configFile);
 	this->csa_opcua_adapter_InitVarMapping();
+	this->csa_opcua_adapter_InitUpdatePump();
 	
 	this->mgr->doStart(); // Implicit: Startet Worker-Threads aller ipc_managed_objects, die mit addObject registriert wurden  
 }
@@ -58,8 +60,13 @@ void csa_opcua_adapter::csa_opcua_adapter_InitVarMapping() {
     // Get all ProcessVariables
     vector<ProcessVariable::SharedPtr> allProcessVariables = this->csManager->getAllProcessVariables();
   
+    vector<string> allNames;
     for(ProcessVariable::SharedPtr oneProcessVariable : allProcessVariables) {
-        adapter->addVariable(oneProcessVariable->getName(), this->csManager);
+        allNames.push_back(oneProcessVariable->getName());
+    }
+    adapter->addVariables(allNames, this->csManager);
+    if(adapter->getFilteredVariableCount() > 0) {
+        cout << adapter->getFilteredVariableCount() << " of " << allNames.size() << " process variables are filtered by <include>/<exclude> and not mapped." << endl;
     }
     
     vector<string> allNotMappedVariables = adapter->getAllNotMappableVariablesNames();
@@ -71,8 +78,52 @@ void csa_opcua_adapter::csa_opcua_adapter_InitVarMapping() {
 		}
 }
 
+void csa_opcua_adapter::csa_opcua_adapter_InitUpdatePump() {
+	// Without the pump every client read receives its processvariable inline
+	this->pump = nullptr;
+	if(!this->adapter->isUpdatePumpEnabled()) {
+		return;
+	}
+	
+	this->pump = new csa_update_pump(this->csManager, CSA_UPDATE_PUMP_INTERVAL);
+	for(ua_processvariable *processvariable : this->adapter->getVariables()) {
+		this->pump->addVariable(processvariable);
+	}
+	this->pump->enableMonitoredItemPush(this->adapter->getMappedServer(), CSA_MONITORED_ITEM_FALLBACK_INTERVAL);
+	
+	// Variables of the lazy instantiation are committed on the server thread while the pump is already running
+	csa_update_pump *pump = this->pump;
+	this->adapter->setVariableListener([pump](ua_processvariable *processvariable) {
+		if(processvariable->enableUpdatePump()) {
+			processvariable->setFallbackSamplingInterval(CSA_MONITORED_ITEM_FALLBACK_INTERVAL);
+			pump->queueVariable(processvariable);
+		}
+	});
+	
+	// Changes of the pump wake the server loop, which then pushes them into the monitored items right away
+	ua_uaadapter *adapter = this->adapter;
+	this->pump->setServerWakeup([adapter]() {
+		adapter->wakeup();
+	});
+	this->adapter->setWakeupListener([pump]() {
+		pump->notifyChanged();
+	});
+	this->mgr->addObject(this->pump);
+}
+
 csa_opcua_adapter::~csa_opcua_adapter() {
 	
+	// The server thread calls the listeners, so it is stopped before they are removed
+	this->mgr->deleteObject(this->adapter->getIpcId());
+	this->adapter->setVariableListener(nullptr);
+	this->adapter->setWakeupListener(nullptr);
+	
+	// Stop pumping before the processvariables are deleted
+	if(this->pump != nullptr) {
+		this->mgr->deleteObject(this->pump->getIpcId());
+		delete this->pump;
+	}
+	
 	this->adapter->~ua_uaadapter();
 	
 	this->mgr->~ipc_manager();
@@ -90,6 +141,10 @@ ipc_manager* csa_opcua_adapter::getIPCManager() {
     return this->mgr;
 }
 
+csa_update_pump* csa_opcua_adapter::getUpdatePump() {
+    return this->pump;
+}
+
 void csa_opcua_adapter::start() {
     this->mgr->startAll();
     return;
@@ -0,0 +1,161 @@
+/* 
+ * This file is part of ChimeraTKs ControlSystem-OPC-UA-Adapter.
+ *
+ * ChimeraTKs ControlSystem-OPC-UA-Adapter is free software: you can 
+ * redistribute it and/or modify it under the terms of the Lesser GNU 
+ * General Public License as published by the Free Software Foundation, 
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ChimeraTKs ControlSystem-OPC-UA-Adapter is distributed in the hope 
+ * that it will be useful, but WITHOUT ANY WARRANTY; without even the 
+ * implied warranty ofMERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+ * See the Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Foobar.  If not, see https://www.gnu.org/licenses/lgpl.html
+ * 
+ * Copyright (c) 2016 Chris Iatrou <Chris_Paul.Iatrou@tu-dresden.de>
+ * Copyright (c) 2016 Julian Rahm  <Julian.Rahm@tu-dresden.de>
+ */
+
+#include "csa_update_pump.h"
+#include "csa_config.h"
+
+csa_update_pump::csa_update_pump_listener::csa_update_pump_listener(csa_update_pump *pump, ua_processvariable *processvariable) {
+	this->pump = pump;
+	this->processvariable = processvariable;
+	this->queued = false;
+	this->changed = false;
+}
+
+void csa_update_pump::csa_update_pump_listener::notify(ProcessVariable::SharedPtr processVariable) {
+	// A burst of updates is published only once, after all of them were received
+	if(!this->queued) {
+		this->queued = true;
+		this->pump->pending.push_back(this);
+	}
+}
+
+csa_update_pump::csa_update_pump(boost::shared_ptr<ControlSystemPVManager> csManager, uint32_t interval) {
+	this->syncUtility.reset(new ControlSystemSynchronizationUtility(csManager));
+	this->interval = interval;
+	this->wakeupPending = false;
+	this->notifyServer = nullptr;
+}
+
+csa_update_pump::~csa_update_pump() {
+	// Joins the pump thread, before the members it uses are destroyed
+	this->doStop();
+}
+
+bool csa_update_pump::addVariable(ua_processvariable *processvariable) {
+	if(!processvariable->enableUpdatePump()) {
+		return false;
+	}
+	
+	boost::shared_ptr<csa_update_pump_listener> listener(new csa_update_pump_listener(this, processvariable));
+	this->listeners.push_back(listener);
+	this->syncUtility->addReceiveNotificationListener(processvariable->getName(), listener);
+	this->pumpedProcessVariables.push_back(processvariable->getProcessVariable());
+	return true;
+}
+
+void csa_update_pump::queueVariable(ua_processvariable *processvariable) {
+	{
+		std::lock_guard<std::mutex> lock(this->lateMutex);
+		this->lateVariables.push_back(processvariable);
+	}
+	this->wakeup();
+}
+
+void csa_update_pump::publishPending() {
+	if(this->pending.empty()) {
+		return;
+	}
+	
+	for(csa_update_pump_listener *listener : this->pending) {
+		listener->processvariable->publishReceivedValue();
+		listener->queued = false;
+	}
+	
+	bool wakeup = false;
+	if(this->notifyServer != nullptr) {
+		std::lock_guard<std::mutex> lock(this->changedMutex);
+		// Only the first change after a notifyChanged wakes the server, it takes over all later ones too
+		wakeup = this->changed.empty();
+		for(csa_update_pump_listener *listener : this->pending) {
+			if(!listener->changed) {
+				listener->changed = true;
+				this->changed.push_back(listener);
+			}
+		}
+	}
+	this->pending.clear();
+	
+	if(wakeup && this->serverWakeup) {
+		this->serverWakeup();
+	}
+}
+
+bool csa_update_pump::enableMonitoredItemPush(UA_Server *server, UA_Double fallbackSamplingInterval) {
+	if(this->notifyServer != nullptr) {
+		return true;
+	}
+	
+	for(boost::shared_ptr<csa_update_pump_listener> listener : this->listeners) {
+		listener->processvariable->setFallbackSamplingInterval(fallbackSamplingInterval);
+	}
+	this->notifyServer = server;
+	return true;
+}
+
+void csa_update_pump::notifyChanged() {
+	std::vector<csa_update_pump_listener *> notify;
+	{
+		std::lock_guard<std::mutex> lock(this->changedMutex);
+		notify.swap(this->changed);
+		for(csa_update_pump_listener *listener : notify) {
+			listener->changed = false;
+		}
+	}
+	
+	for(csa_update_pump_listener *listener : notify) {
+		listener->processvariable->notifyMonitoredItems();
+	}
+}
+
+void csa_update_pump::setServerWakeup(std::function<void()> wakeup) {
+	this->serverWakeup = wakeup;
+}
+
+void csa_update_pump::pumpOnce() {
+	std::vector<ua_processvariable *> added;
+	{
+		std::lock_guard<std::mutex> lock(this->lateMutex);
+		added.swap(this->lateVariables);
+	}
+	for(ua_processvariable *processvariable : added) {
+		this->addVariable(processvariable);
+	}
+	
+	this->syncUtility->receive(this->pumpedProcessVariables);
+	this->publishPending();
+}
+
+void csa_update_pump::wakeup() {
+	{
+		std::lock_guard<std::mutex> lock(this->mtx_threadOperations);
+		this->wakeupPending = true;
+	}
+	this->stateChanged.notify_all();
+}
+
+void csa_update_pump::workerThread() {
+	while(this->isRunning()) {
+		this->pumpOnce();
+		// Sleep until the next wakeup or for the interval at most, doStop notifies stateChanged as well
+		std::unique_lock<std::mutex> lock(this->mtx_threadOperations);
+		this->stateChanged.wait_for(lock, std::chrono::milliseconds(this->interval), [this] { return this->wakeupPending || !this->thread_run; });
+		this->wakeupPending = false;
+	}
+}
@@ -79,13 +79,46 @@ bool ipc_managed_object::isRunning()
 
 bool ipc_managed_object::taskRunningAttached() 
 {
+  if (this->threadTask == nullptr)
+    return false;
   return this->threadTask->joinable();
 }
 
+void ipc_managed_object::waitForStop()
+{
+  std::unique_lock<std::mutex> lock(this->mtx_threadOperations);
+  this->stateChanged.wait(lock, [this] { return !this->thread_run; });
+}
+
+bool ipc_managed_object::waitForStop(std::chrono::milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock(this->mtx_threadOperations);
+  return this->stateChanged.wait_for(lock, timeout, [this] { return !this->thread_run; });
+}
+
+void ipc_managed_object::stopRequested()
+{
+}
+
 uint32_t ipc_managed_object::doStop()
 {
   cout << "ipc_managed_object being stopped" << endl;
+  std::thread *stoppedTask = nullptr;
+  this->mtx_threadOperations.lock();
   this->thread_run = false;
+  if (this->threadTask != nullptr && this->threadTask->get_id() != std::this_thread::get_id()) {
+    stoppedTask = this->threadTask;
+    this->threadTask = nullptr;
+  }
+  this->mtx_threadOperations.unlock();
+  this->stateChanged.notify_all();
+  this->stopRequested();
+  
+  if (stoppedTask != nullptr) {
+    if (stoppedTask->joinable())
+      stoppedTask->join();
+    delete stoppedTask;
+  }
   cout << "ipc_managed_object was stopped" << endl;
   return 0;
 }
@@ -97,6 +130,12 @@ uint32_t ipc_managed_object::doStart()
     this->mtx_threadOperations.unlock();
     return 0;
   }
+  // A worker which stopped itself was not joined yet
+  if (this->threadTask != nullptr) {
+    if (this->threadTask->joinable())
+      this->threadTask->join();
+    delete this->threadTask;
+  }
   this->thread_run = true;
   this->threadTask = new std::thread(ipc_managed_object_callWorker, this);
   this->mtx_threadOperations.unlock();
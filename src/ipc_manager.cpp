@@ -41,29 +41,16 @@ ipc_manager::~ipc_manager() {
 	//for(auto ptr : this->objects) delete ptr;
 }
 
-static void call_periodiclyKickWorkerThread(ipc_manager *mgr) {mgr->periodiclyKickWorkerThread();}
-void ipc_manager::periodiclyKickWorkerThread()
-{
-  //timespec t_periodic = (const struct timespec) {.tv_sec=0, .tv_nsec=IPC_MANAGER_PERIODIC_IDLEUPATEINTERVAL*1000000};
-  
-  while(this->thread_run) {
-    this->notifier.notify_all();
-    sleep(1);
-  }
-}
-
 void ipc_manager::workerThread()
 {
   std::unique_lock<std::mutex> lock(this->mtx_threadOperations);
-  std::thread kicker(call_periodiclyKickWorkerThread, this);
   while(this->thread_run) 
   {
-    this->notifier.wait(lock);
+    // Woken by addObject and doStop only, an idle manager does not wake up
+    this->stateChanged.wait(lock);
     
     // Check Tasks
   }
-  if (kicker.joinable())
-    kicker.join();
   return;
 }
 
@@ -78,7 +65,7 @@ uint32_t ipc_manager::addObject(ipc_managed_object *object)
   this->objects.push_back(object);
   object->doStart();
   
-  this->notifier.notify_all();
+  this->stateChanged.notify_all();
   
   return object->getIpcId();
 }
@@ -126,12 +113,7 @@ void ipc_manager::stopAll() {
 		//obj = NULL;
   }
   
-  // Stop our own thread
-  this->thread_run = false;
-  sleep(1);
-  this->notifier.notify_all();
-  sleep(1);
-  this->notifier.notify_all();
+  // Stop our own thread, doStop wakes it up and waits for it
   this->doStop();
   
   return;
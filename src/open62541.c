@@ -3441,6 +3441,9 @@ typedef struct {
     UA_Byte userAccessLevel;
     UA_Double minimumSamplingInterval;
     UA_Boolean historizing; /* currently unsupported */
+    /* Deadband for monitored items which do not set a deadband */
+    UA_DeadbandType deadbandType;
+    UA_Double deadbandValue;
 } UA_VariableNode;
 
 /**
@@ -3816,6 +3819,8 @@ typedef struct MonitoredItem_queuedValue {
 
 typedef struct UA_MonitoredItem {
     LIST_ENTRY(UA_MonitoredItem) listEntry;
+    LIST_ENTRY(UA_MonitoredItem) indexEntry; /* in the server's monitored item index */
+    UA_Boolean indexed;
 
     /* Settings */
     UA_Subscription *subscription;
@@ -3833,6 +3838,8 @@ typedef struct UA_MonitoredItem {
     UA_String indexRange;
     // TODO: dataEncoding is hardcoded to UA binary
     UA_DataChangeTrigger trigger;
+    UA_DeadbandType deadbandType;
+    UA_Double deadbandValue;
 
     /* Sample Job */
     UA_Guid sampleJobGuid;
@@ -3840,11 +3847,24 @@ typedef struct UA_MonitoredItem {
 
     /* Sample Queue */
     UA_ByteString lastSampledValue;
+    UA_Variant lastReportedValue; /* only kept for the deadband */
+    UA_StatusCode lastReportedStatus;
     TAILQ_HEAD(QueueOfQueueDataValues, MonitoredItem_queuedValue) queue;
 } UA_MonitoredItem;
 
+/* Monitored items of the value attribute, chained by the hash of their node
+ * id. Pushing the change of a node only visits the items in its chain. */
+LIST_HEAD(UA_MonitoredItemBucket, UA_MonitoredItem);
+typedef struct {
+    struct UA_MonitoredItemBucket *buckets;
+    size_t bucketsSize;
+    size_t count;
+} UA_MonitoredItemIndex;
+
 UA_MonitoredItem *UA_MonitoredItem_new(void);
 void MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *monitoredItem);
+void MonitoredItem_addToIndex(UA_Server *server, UA_MonitoredItem *mon);
+void MonitoredItem_removeFromIndex(UA_Server *server, UA_MonitoredItem *mon);
 void UA_MoniteredItem_SampleCallback(UA_Server *server, UA_MonitoredItem *monitoredItem);
 UA_StatusCode MonitoredItem_registerSampleJob(UA_Server *server, UA_MonitoredItem *mon);
 UA_StatusCode MonitoredItem_unregisterSampleJob(UA_Server *server, UA_MonitoredItem *mon);
@@ -4210,6 +4230,17 @@ struct UA_Server {
     struct cds_wfcq_tail dispatchQueue_tail; /* Dispatch queue tail for the worker threads */
 #endif
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    /* Monitored items of the value attribute by their node */
+    UA_MonitoredItemIndex monitoredItemIndex;
+#endif
+
+    /* Brackets the WriteRequests of clients */
+    UA_WriteRequestCallback writeRequestCallback;
+
+    /* Announces browsed and read nodes before they are looked up */
+    UA_NodeAccessCallback nodeAccessCallback;
+
     /* Config is the last element so that MSVC allows the usernamePasswordLogins
        field with zero-sized array */
     UA_ServerConfig config;
@@ -15808,13 +15839,25 @@ static void deleteInstanceChildren(UA_Server *server, UA_NodeId *objectNodeId) {
 /**********/
 
 /* The server needs to be stopped before it can be deleted */
+#ifndef UA_ENABLE_MULTITHREADING
+static void processDelayedCallbacks(UA_Server *server);
+#endif
+
 void UA_Server_delete(UA_Server *server) {
     // Delete the timed work
     UA_Server_deleteAllRepeatedJobs(server);
+#ifndef UA_ENABLE_MULTITHREADING
+    // Delayed callbacks may own memory, e.g. when the server never ran
+    processDelayedCallbacks(server);
+#endif
 
     // Delete all internal data
     UA_SecureChannelManager_deleteMembers(&server->secureChannelManager);
     UA_SessionManager_deleteMembers(&server->sessionManager);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    /* The monitored items left the index with their sessions */
+    UA_free(server->monitoredItemIndex.buckets);
+#endif
     UA_RCU_LOCK();
     UA_NodeStore_delete(server->nodestore);
     UA_RCU_UNLOCK();
@@ -18186,6 +18229,14 @@ UA_StatusCode UA_Server_removeRepeatedJob(UA_Server *server, UA_Guid jobId) {
     return UA_STATUSCODE_GOOD;
 }
 
+UA_DateTime UA_Server_getNextRepeatedJobTime(UA_Server *server) {
+    /* The list is sorted by nextTime */
+    struct RepeatedJob *first = LIST_FIRST(&server->repeatedJobs);
+    if(!first)
+        return UA_INT64_MAX;
+    return first->nextTime;
+}
+
 void UA_Server_deleteAllRepeatedJobs(UA_Server *server) {
     struct RepeatedJob *current, *temp;
     LIST_FOREACH_SAFE(current, &server->repeatedJobs, next, temp) {
@@ -18913,6 +18964,8 @@ UA_VariableNode_copy(const UA_VariableNode *src, UA_VariableNode *dst) {
     dst->userAccessLevel = src->userAccessLevel;
     dst->minimumSamplingInterval = src->minimumSamplingInterval;
     dst->historizing = src->historizing;
+    dst->deadbandType = src->deadbandType;
+    dst->deadbandValue = src->deadbandValue;
     return retval;
 }
 
@@ -20587,6 +20640,9 @@ void Service_Read_single(UA_Server *server, UA_Session *session,
     UA_LOG_DEBUG_SESSION(server->config.logger, session,
                          "Read the attribute %i", id->attributeId);
 
+    if(server->nodeAccessCallback.onAccess)
+        server->nodeAccessCallback.onAccess(server->nodeAccessCallback.handle, &id->nodeId);
+
     /* XML encoding is not supported */
     if(id->dataEncoding.name.length > 0 &&
        !UA_String_equal(&binEncoding, &id->dataEncoding.name)) {
@@ -21048,6 +21104,17 @@ CopyAttributeIntoNode(UA_Server *server, UA_Session *session,
     return retval;
 }
 
+/* Mark the write of node i as deferred if the data source deferred a write */
+static void
+recordDeferredWrite(const UA_WriteRequestCallback *callback, UA_Boolean *deferred,
+                    size_t *deferredCount, size_t i) {
+    if(!deferred)
+        return;
+    size_t count = callback->deferredWrites(callback->handle);
+    deferred[i] = (count != *deferredCount);
+    *deferredCount = count;
+}
+
 void
 Service_Write(UA_Server *server, UA_Session *session,
               const UA_WriteRequest *request, UA_WriteResponse *response) {
@@ -21064,11 +21131,24 @@ Service_Write(UA_Server *server, UA_Session *session,
     }
     response->resultsSize = request->nodesToWriteSize;
 
+    const UA_WriteRequestCallback *callback = &server->writeRequestCallback;
+    if(callback->begin)
+        callback->begin(callback->handle);
+
+    /* Remember which writes were deferred, only they are abandoned by end() */
+    UA_Boolean *deferred = NULL;
+    size_t deferredCount = 0;
+    if(callback->end && callback->deferredWrites) {
+        deferred = (UA_Boolean*)UA_calloc(request->nodesToWriteSize, sizeof(UA_Boolean));
+        deferredCount = callback->deferredWrites(callback->handle);
+    }
+
 #ifndef UA_ENABLE_EXTERNAL_NAMESPACES
     for(size_t i = 0;i < request->nodesToWriteSize;++i) {
         response->results[i] = UA_Server_editNode(server, session, &request->nodesToWrite[i].nodeId,
                                                   (UA_EditNodeCallback)CopyAttributeIntoNode,
                                                   &request->nodesToWrite[i]);
+        recordDeferredWrite(callback, deferred, &deferredCount, i);
     }
 #else
     UA_Boolean isExternal[request->nodesToWriteSize];
@@ -21096,8 +21176,39 @@ Service_Write(UA_Server *server, UA_Session *session,
         response->results[i] = UA_Server_editNode(server, session, &request->nodesToWrite[i].nodeId,
                                                   (UA_EditNodeCallback)CopyAttributeIntoNode,
                                                   &request->nodesToWrite[i]);
+        recordDeferredWrite(callback, deferred, &deferredCount, i);
     }
 #endif
+
+    if(!callback->end)
+        return;
+    UA_Boolean failed = false;
+    for(size_t i = 0; i < response->resultsSize; ++i) {
+        if(response->results[i] != UA_STATUSCODE_GOOD)
+            failed = true;
+    }
+    UA_StatusCode retval = callback->end(callback->handle, failed);
+    if(retval != UA_STATUSCODE_GOOD) {
+        /* Without the record every good result may have been deferred */
+        UA_Boolean recorded = (deferred != NULL);
+        for(size_t i = 0; i < response->resultsSize; ++i) {
+            if(response->results[i] == UA_STATUSCODE_GOOD && (!recorded || deferred[i]))
+                response->results[i] = retval;
+        }
+    }
+    UA_free(deferred);
+}
+
+void
+UA_Server_setWriteRequestCallback(UA_Server *server,
+                                  const UA_WriteRequestCallback callback) {
+    server->writeRequestCallback = callback;
+}
+
+void
+UA_Server_setNodeAccessCallback(UA_Server *server,
+                                const UA_NodeAccessCallback callback) {
+    server->nodeAccessCallback = callback;
 }
 
 UA_StatusCode
@@ -21370,7 +21481,7 @@ setObjectInstanceHandle(UA_Server *server, UA_Session *session,
 
 static UA_StatusCode
 instantiateNode(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
-                UA_NodeClass nodeClass, const UA_NodeId *typeId,
+                UA_NodeClass nodeClass, const UA_NodeId *typeId, UA_Boolean copyMembers,
                 UA_InstantiationCallback *instantiationCallback) {
     /* see if the type node is correct */
     const UA_Node *typenode = UA_NodeStore_get(server->nodestore, typeId);
@@ -21388,20 +21499,20 @@ instantiateNode(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
         return UA_STATUSCODE_BADTYPEDEFINITIONINVALID;
     }
 
-    /* Get the hierarchy of the type and all its supertypes */
-    UA_NodeId *hierarchy = NULL;
-    size_t hierarchySize = 0;
-    UA_StatusCode retval =
-        getTypeHierarchy(server->nodestore, typenode, true, &hierarchy, &hierarchySize);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
-    
-    /* Copy members of the type and supertypes */
-    for(size_t i = 0; i < hierarchySize; ++i)
-        retval |= copyChildNodesToNode(server, session, &hierarchy[i], nodeId, instantiationCallback);
-    UA_Array_delete(hierarchy, hierarchySize, &UA_TYPES[UA_TYPES_NODEID]);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
+    /* Copy members of the type and supertypes, unless the caller adds them */
+    if(copyMembers) {
+        UA_NodeId *hierarchy = NULL;
+        size_t hierarchySize = 0;
+        UA_StatusCode retval =
+            getTypeHierarchy(server->nodestore, typenode, true, &hierarchy, &hierarchySize);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+        for(size_t i = 0; i < hierarchySize; ++i)
+            retval |= copyChildNodesToNode(server, session, &hierarchy[i], nodeId, instantiationCallback);
+        UA_Array_delete(hierarchy, hierarchySize, &UA_TYPES[UA_TYPES_NODEID]);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
 
     /* Call the object constructor */
     if(typenode->nodeClass == UA_NODECLASS_OBJECTTYPE) {
@@ -21542,12 +21653,12 @@ copyChildNodesToNode(UA_Server* server, UA_Session* session,
     return retval;
 }
 
-UA_StatusCode
-Service_AddNodes_existing(UA_Server *server, UA_Session *session, UA_Node *node,
-                          const UA_NodeId *parentNodeId, const UA_NodeId *referenceTypeId,
-                          const UA_NodeId *typeDefinition,
-                          UA_InstantiationCallback *instantiationCallback,
-                          UA_NodeId *addedNodeId) {
+static UA_StatusCode
+addNodeExisting(UA_Server *server, UA_Session *session, UA_Node *node,
+                const UA_NodeId *parentNodeId, const UA_NodeId *referenceTypeId,
+                const UA_NodeId *typeDefinition, UA_Boolean copyMembers,
+                UA_InstantiationCallback *instantiationCallback,
+                UA_NodeId *addedNodeId) {
     UA_ASSERT_RCU_LOCKED();
 
     /* Check the namespaceindex */
@@ -21616,7 +21727,7 @@ Service_AddNodes_existing(UA_Server *server, UA_Session *session, UA_Node *node,
 
         /* Instantiate variables and objects */
         retval = instantiateNode(server, session, &node->nodeId, node->nodeClass,
-                                 typeDefinition, instantiationCallback);
+                                 typeDefinition, copyMembers, instantiationCallback);
         if(retval != UA_STATUSCODE_GOOD) {
             UA_LOG_INFO_SESSION(server->config.logger, session,
                                 "AddNodes: Could not instantiate the node with"
@@ -21636,6 +21747,16 @@ Service_AddNodes_existing(UA_Server *server, UA_Session *session, UA_Node *node,
     return retval;
 }
 
+UA_StatusCode
+Service_AddNodes_existing(UA_Server *server, UA_Session *session, UA_Node *node,
+                          const UA_NodeId *parentNodeId, const UA_NodeId *referenceTypeId,
+                          const UA_NodeId *typeDefinition,
+                          UA_InstantiationCallback *instantiationCallback,
+                          UA_NodeId *addedNodeId) {
+    return addNodeExisting(server, session, node, parentNodeId, referenceTypeId,
+                           typeDefinition, true, instantiationCallback, addedNodeId);
+}
+
 /*******************************************/
 /* Create nodes from attribute description */
 /*******************************************/
@@ -22031,6 +22152,36 @@ UA_Server_addDataSourceVariableNode(UA_Server *server, const UA_NodeId requested
     return retval;
 }
 
+UA_StatusCode
+UA_Server_addObjectNode_withoutMembers(UA_Server *server, const UA_NodeId requestedNewNodeId,
+                                       const UA_NodeId parentNodeId,
+                                       const UA_NodeId referenceTypeId,
+                                       const UA_QualifiedName browseName,
+                                       const UA_NodeId typeDefinition,
+                                       const UA_ObjectAttributes attr,
+                                       UA_NodeId *outNewNodeId) {
+    UA_AddNodesItem item;
+    UA_AddNodesItem_init(&item);
+    item.parentNodeId.nodeId = parentNodeId;
+    item.referenceTypeId = referenceTypeId;
+    item.requestedNewNodeId.nodeId = requestedNewNodeId;
+    item.browseName = browseName;
+    item.nodeClass = UA_NODECLASS_OBJECT;
+    item.typeDefinition.nodeId = typeDefinition;
+    item.nodeAttributes = (UA_ExtensionObject){
+        .encoding = UA_EXTENSIONOBJECT_DECODED_NODELETE,
+        .content.decoded = {&UA_TYPES[UA_TYPES_OBJECTATTRIBUTES], (void*)(uintptr_t)&attr}};
+
+    UA_Node *node = NULL;
+    UA_RCU_LOCK();
+    UA_StatusCode retval = createNodeFromAttributes(server, &item, &node);
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = addNodeExisting(server, &adminSession, node, &parentNodeId, &referenceTypeId,
+                                 &typeDefinition, false, NULL, outNewNodeId);
+    UA_RCU_UNLOCK();
+    return retval;
+}
+
 #ifdef UA_ENABLE_METHODCALLS
 
 UA_StatusCode
@@ -22529,6 +22680,423 @@ UA_Server_setVariableNode_dataSource(UA_Server *server, const UA_NodeId nodeId,
     return retval;
 }
 
+static UA_StatusCode
+setDataSourceAttributes(UA_Server *server, UA_Session *session,
+                        UA_VariableNode* node, const UA_DataSourceAttributes *attributes) {
+    if(node->nodeClass != UA_NODECLASS_VARIABLE)
+        return UA_STATUSCODE_BADNODECLASSINVALID;
+    UA_LocalizedText description;
+    UA_StatusCode retval = UA_LocalizedText_copy(&attributes->description, &description);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    if(attributes->dataType) {
+        /* Type ids of the builtin types are numeric, copying does not fail */
+        UA_NodeId_deleteMembers(&node->dataType);
+        UA_NodeId_copy(&attributes->dataType->typeId, &node->dataType);
+        node->valueRank = attributes->valueRank;
+    }
+    UA_LocalizedText_deleteMembers(&node->description);
+    node->description = description;
+    node->accessLevel = attributes->accessLevel;
+    node->userAccessLevel = attributes->accessLevel;
+    UA_DataSource dataSource = attributes->dataSource;
+    return setDataSource(server, session, node, &dataSource);
+}
+
+UA_StatusCode
+UA_Server_setVariableNode_dataSourceAttributes(UA_Server *server, const UA_NodeId nodeId,
+                                               const UA_DataSourceAttributes *attributes) {
+    UA_RCU_LOCK();
+    UA_StatusCode retval = UA_Server_editNode(server, &adminSession, &nodeId,
+                                              (UA_EditNodeCallback)setDataSourceAttributes,
+                                              (void*)attributes);
+    UA_RCU_UNLOCK();
+    return retval;
+}
+
+/****************/
+/* Set Deadband */
+/****************/
+
+typedef struct {
+    UA_DeadbandType deadbandType;
+    UA_Double deadbandValue;
+} UA_Deadband;
+
+static UA_StatusCode
+setDeadband(UA_Server *server, UA_Session *session,
+            UA_VariableNode* node, UA_Deadband *deadband) {
+    if(node->nodeClass != UA_NODECLASS_VARIABLE)
+        return UA_STATUSCODE_BADNODECLASSINVALID;
+    node->deadbandType = deadband->deadbandType;
+    node->deadbandValue = deadband->deadbandValue;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_Server_setVariableNode_deadband(UA_Server *server, const UA_NodeId nodeId,
+                                   const UA_DeadbandType deadbandType,
+                                   const UA_Double deadbandValue) {
+    if(deadbandType > UA_DEADBANDTYPE_PERCENT || !(deadbandValue >= 0.0))
+        return UA_STATUSCODE_BADDEADBANDFILTERINVALID;
+    UA_Deadband deadband = {deadbandType, deadbandValue};
+    UA_RCU_LOCK();
+    UA_StatusCode retval = UA_Server_editNode(server, &adminSession, &nodeId,
+                                              (UA_EditNodeCallback)setDeadband, &deadband);
+    UA_RCU_UNLOCK();
+    return retval;
+}
+
+/******************/
+/* Node Snapshots */
+/******************/
+
+/* Encodes one member, or only adds its encoded size if dst is NULL */
+static UA_StatusCode
+snapshotMember(const void *src, const UA_DataType *type, UA_ByteString *dst, size_t *offset) {
+    if(!dst) {
+        *offset += UA_calcSizeBinary((void*)(uintptr_t)src, type);
+        return UA_STATUSCODE_GOOD;
+    }
+    return UA_encodeBinary(src, type, NULL, NULL, dst, offset);
+}
+
+static UA_StatusCode
+snapshotNode(const UA_Node *node, UA_ByteString *dst, size_t *offset) {
+    if(node->nodeClass != UA_NODECLASS_OBJECT && node->nodeClass != UA_NODECLASS_VARIABLE)
+        return UA_STATUSCODE_BADNODECLASSINVALID;
+    UA_Int32 nodeClass = (UA_Int32)node->nodeClass;
+    UA_UInt32 referencesSize = (UA_UInt32)node->referencesSize;
+    UA_StatusCode retval = snapshotMember(&nodeClass, &UA_TYPES[UA_TYPES_INT32], dst, offset);
+    retval |= snapshotMember(&node->nodeId, &UA_TYPES[UA_TYPES_NODEID], dst, offset);
+    retval |= snapshotMember(&node->browseName, &UA_TYPES[UA_TYPES_QUALIFIEDNAME], dst, offset);
+    retval |= snapshotMember(&node->displayName, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT], dst, offset);
+    retval |= snapshotMember(&node->description, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT], dst, offset);
+    retval |= snapshotMember(&node->writeMask, &UA_TYPES[UA_TYPES_UINT32], dst, offset);
+    retval |= snapshotMember(&node->userWriteMask, &UA_TYPES[UA_TYPES_UINT32], dst, offset);
+    retval |= snapshotMember(&referencesSize, &UA_TYPES[UA_TYPES_UINT32], dst, offset);
+    for(size_t i = 0; i < node->referencesSize; ++i) {
+        const UA_ReferenceNode *ref = &node->references[i];
+        retval |= snapshotMember(&ref->referenceTypeId, &UA_TYPES[UA_TYPES_NODEID], dst, offset);
+        retval |= snapshotMember(&ref->isInverse, &UA_TYPES[UA_TYPES_BOOLEAN], dst, offset);
+        retval |= snapshotMember(&ref->targetId, &UA_TYPES[UA_TYPES_EXPANDEDNODEID], dst, offset);
+    }
+    if(node->nodeClass == UA_NODECLASS_OBJECT)
+        return retval | snapshotMember(&((const UA_ObjectNode*)node)->eventNotifier,
+                                       &UA_TYPES[UA_TYPES_BYTE], dst, offset);
+
+    const UA_VariableNode *vnode = (const UA_VariableNode*)node;
+    UA_UInt32 arrayDimensionsSize = (UA_UInt32)vnode->arrayDimensionsSize;
+    UA_Int32 deadbandType = (UA_Int32)vnode->deadbandType;
+    /* Values of data sources are not part of the snapshot */
+    UA_DataValue noValue;
+    UA_DataValue_init(&noValue);
+    const UA_DataValue *value = &noValue;
+    if(vnode->valueSource == UA_VALUESOURCE_DATA)
+        value = &vnode->value.data.value;
+    retval |= snapshotMember(&vnode->dataType, &UA_TYPES[UA_TYPES_NODEID], dst, offset);
+    retval |= snapshotMember(&vnode->valueRank, &UA_TYPES[UA_TYPES_INT32], dst, offset);
+    retval |= snapshotMember(&arrayDimensionsSize, &UA_TYPES[UA_TYPES_UINT32], dst, offset);
+    for(size_t i = 0; i < vnode->arrayDimensionsSize; ++i)
+        retval |= snapshotMember(&vnode->arrayDimensions[i], &UA_TYPES[UA_TYPES_UINT32], dst, offset);
+    retval |= snapshotMember(&vnode->accessLevel, &UA_TYPES[UA_TYPES_BYTE], dst, offset);
+    retval |= snapshotMember(&vnode->userAccessLevel, &UA_TYPES[UA_TYPES_BYTE], dst, offset);
+    retval |= snapshotMember(&vnode->minimumSamplingInterval, &UA_TYPES[UA_TYPES_DOUBLE], dst, offset);
+    retval |= snapshotMember(&vnode->historizing, &UA_TYPES[UA_TYPES_BOOLEAN], dst, offset);
+    retval |= snapshotMember(&deadbandType, &UA_TYPES[UA_TYPES_INT32], dst, offset);
+    retval |= snapshotMember(&vnode->deadbandValue, &UA_TYPES[UA_TYPES_DOUBLE], dst, offset);
+    retval |= snapshotMember(value, &UA_TYPES[UA_TYPES_DATAVALUE], dst, offset);
+    return retval;
+}
+
+UA_StatusCode
+UA_Server_encodeNodes(UA_Server *server, const UA_NodeId *nodeIds,
+                      size_t nodeIdsSize, UA_ByteString *dst) {
+    UA_ByteString_init(dst);
+    UA_UInt32 count = (UA_UInt32)nodeIdsSize;
+    size_t size = 0;
+    UA_RCU_LOCK();
+    /* The first pass sizes the buffer, the second pass encodes into it */
+    UA_StatusCode retval = snapshotMember(&count, &UA_TYPES[UA_TYPES_UINT32], NULL, &size);
+    for(size_t i = 0; i < nodeIdsSize && retval == UA_STATUSCODE_GOOD; ++i) {
+        const UA_Node *node = UA_NodeStore_get(server->nodestore, &nodeIds[i]);
+        if(!node)
+            retval = UA_STATUSCODE_BADNODEIDUNKNOWN;
+        else
+            retval = snapshotNode(node, NULL, &size);
+    }
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = UA_ByteString_allocBuffer(dst, size);
+    size_t offset = 0;
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = snapshotMember(&count, &UA_TYPES[UA_TYPES_UINT32], dst, &offset);
+    for(size_t i = 0; i < nodeIdsSize && retval == UA_STATUSCODE_GOOD; ++i)
+        retval = snapshotNode(UA_NodeStore_get(server->nodestore, &nodeIds[i]), dst, &offset);
+    UA_RCU_UNLOCK();
+    if(retval != UA_STATUSCODE_GOOD)
+        UA_ByteString_deleteMembers(dst);
+    return retval;
+}
+
+static UA_StatusCode
+restoreNode(const UA_ByteString *src, size_t *offset, UA_Node **restored) {
+    UA_Int32 nodeClass = 0;
+    UA_StatusCode retval = UA_decodeBinary(src, offset, &nodeClass, &UA_TYPES[UA_TYPES_INT32]);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    if(nodeClass != UA_NODECLASS_OBJECT && nodeClass != UA_NODECLASS_VARIABLE)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    UA_Node *node = UA_NodeStore_newNode((UA_NodeClass)nodeClass);
+    if(!node)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    UA_UInt32 referencesSize = 0;
+    retval |= UA_decodeBinary(src, offset, &node->nodeId, &UA_TYPES[UA_TYPES_NODEID]);
+    retval |= UA_decodeBinary(src, offset, &node->browseName, &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
+    retval |= UA_decodeBinary(src, offset, &node->displayName, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    retval |= UA_decodeBinary(src, offset, &node->description, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    retval |= UA_decodeBinary(src, offset, &node->writeMask, &UA_TYPES[UA_TYPES_UINT32]);
+    retval |= UA_decodeBinary(src, offset, &node->userWriteMask, &UA_TYPES[UA_TYPES_UINT32]);
+    retval |= UA_decodeBinary(src, offset, &referencesSize, &UA_TYPES[UA_TYPES_UINT32]);
+    if(retval == UA_STATUSCODE_GOOD && referencesSize > 0) {
+        if(referencesSize > src->length) {
+            retval = UA_STATUSCODE_BADDECODINGERROR;
+        } else {
+            node->references = UA_calloc(referencesSize, sizeof(UA_ReferenceNode));
+            if(!node->references)
+                retval = UA_STATUSCODE_BADOUTOFMEMORY;
+            else
+                node->referencesSize = referencesSize;
+        }
+    }
+    for(size_t i = 0; i < node->referencesSize && retval == UA_STATUSCODE_GOOD; ++i) {
+        UA_ReferenceNode *ref = &node->references[i];
+        retval |= UA_decodeBinary(src, offset, &ref->referenceTypeId, &UA_TYPES[UA_TYPES_NODEID]);
+        retval |= UA_decodeBinary(src, offset, &ref->isInverse, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        retval |= UA_decodeBinary(src, offset, &ref->targetId, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    }
+
+    if(retval == UA_STATUSCODE_GOOD && nodeClass == UA_NODECLASS_OBJECT) {
+        retval = UA_decodeBinary(src, offset, &((UA_ObjectNode*)node)->eventNotifier,
+                                 &UA_TYPES[UA_TYPES_BYTE]);
+    } else if(retval == UA_STATUSCODE_GOOD) {
+        UA_VariableNode *vnode = (UA_VariableNode*)node;
+        UA_UInt32 arrayDimensionsSize = 0;
+        UA_Int32 deadbandType = 0;
+        retval |= UA_decodeBinary(src, offset, &vnode->dataType, &UA_TYPES[UA_TYPES_NODEID]);
+        retval |= UA_decodeBinary(src, offset, &vnode->valueRank, &UA_TYPES[UA_TYPES_INT32]);
+        retval |= UA_decodeBinary(src, offset, &arrayDimensionsSize, &UA_TYPES[UA_TYPES_UINT32]);
+        if(retval == UA_STATUSCODE_GOOD && arrayDimensionsSize > 0) {
+            if(arrayDimensionsSize > src->length) {
+                retval = UA_STATUSCODE_BADDECODINGERROR;
+            } else {
+                vnode->arrayDimensions = UA_calloc(arrayDimensionsSize, sizeof(UA_UInt32));
+                if(!vnode->arrayDimensions)
+                    retval = UA_STATUSCODE_BADOUTOFMEMORY;
+                else
+                    vnode->arrayDimensionsSize = arrayDimensionsSize;
+            }
+        }
+        for(size_t i = 0; i < vnode->arrayDimensionsSize && retval == UA_STATUSCODE_GOOD; ++i)
+            retval = UA_decodeBinary(src, offset, &vnode->arrayDimensions[i], &UA_TYPES[UA_TYPES_UINT32]);
+        retval |= UA_decodeBinary(src, offset, &vnode->accessLevel, &UA_TYPES[UA_TYPES_BYTE]);
+        retval |= UA_decodeBinary(src, offset, &vnode->userAccessLevel, &UA_TYPES[UA_TYPES_BYTE]);
+        retval |= UA_decodeBinary(src, offset, &vnode->minimumSamplingInterval, &UA_TYPES[UA_TYPES_DOUBLE]);
+        retval |= UA_decodeBinary(src, offset, &vnode->historizing, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        retval |= UA_decodeBinary(src, offset, &deadbandType, &UA_TYPES[UA_TYPES_INT32]);
+        retval |= UA_decodeBinary(src, offset, &vnode->deadbandValue, &UA_TYPES[UA_TYPES_DOUBLE]);
+        vnode->deadbandType = (UA_DeadbandType)deadbandType;
+        vnode->valueSource = UA_VALUESOURCE_DATA;
+        retval |= UA_decodeBinary(src, offset, &vnode->value.data.value, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    }
+
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_NodeStore_deleteNode(node);
+        return retval;
+    }
+    *restored = node;
+    return UA_STATUSCODE_GOOD;
+}
+
+typedef struct {
+    const UA_AddReferencesItem *items;
+    size_t itemsSize;
+} UA_RestoredReferences;
+
+/* Adds the inverse references of restored nodes to a node outside of the snapshot */
+static UA_StatusCode
+addRestoredReferences(UA_Server *server, UA_Session *session,
+                      UA_Node *node, const UA_RestoredReferences *restored) {
+    UA_ReferenceNode *references = UA_realloc(node->references,
+        sizeof(UA_ReferenceNode) * (node->referencesSize + restored->itemsSize));
+    if(!references)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    node->references = references;
+    for(size_t i = 0; i < restored->itemsSize; ++i) {
+        UA_ReferenceNode *ref = &node->references[node->referencesSize];
+        UA_ReferenceNode_init(ref);
+        UA_StatusCode retval = UA_NodeId_copy(&restored->items[i].referenceTypeId, &ref->referenceTypeId);
+        retval |= UA_ExpandedNodeId_copy(&restored->items[i].targetNodeId, &ref->targetId);
+        ref->isInverse = !restored->items[i].isForward;
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_ReferenceNode_deleteMembers(ref);
+            return retval;
+        }
+        ++node->referencesSize;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Removes the references added by addRestoredReferences again. References
+ * which were not added are skipped. */
+static UA_StatusCode
+removeRestoredReferences(UA_Server *server, UA_Session *session,
+                         UA_Node *node, const UA_RestoredReferences *restored) {
+    for(size_t i = 0; i < restored->itemsSize; ++i) {
+        const UA_AddReferencesItem *item = &restored->items[i];
+        /* Added references are at the end */
+        for(size_t j = node->referencesSize; j > 0; --j) {
+            UA_ReferenceNode *ref = &node->references[j - 1];
+            if(ref->isInverse != !item->isForward ||
+               !UA_NodeId_equal(&ref->referenceTypeId, &item->referenceTypeId) ||
+               !UA_NodeId_equal(&ref->targetId.nodeId, &item->targetNodeId.nodeId))
+                continue;
+            UA_ReferenceNode_deleteMembers(ref);
+            memmove(ref, ref + 1, sizeof(UA_ReferenceNode) * (node->referencesSize - j));
+            --node->referencesSize;
+            break;
+        }
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static int
+compareRestoredReferences(const void *a, const void *b) {
+    UA_UInt32 hashA = UA_NodeId_hash(&((const UA_AddReferencesItem*)a)->sourceNodeId);
+    UA_UInt32 hashB = UA_NodeId_hash(&((const UA_AddReferencesItem*)b)->sourceNodeId);
+    return (hashA > hashB) - (hashA < hashB);
+}
+
+UA_StatusCode
+UA_Server_decodeNodes(UA_Server *server, const UA_ByteString *src,
+                      const UA_NodeId *remapFrom, const UA_NodeId *remapTo,
+                      size_t remapSize) {
+    size_t offset = 0;
+    UA_UInt32 count = 0;
+    UA_StatusCode retval = UA_decodeBinary(src, &offset, &count, &UA_TYPES[UA_TYPES_UINT32]);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    if(count > src->length)
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    UA_NodeId *inserted = UA_calloc(count > 0 ? count : 1, sizeof(UA_NodeId));
+    if(!inserted)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    size_t insertedSize = 0;
+    /* The inverse references to add to nodes outside of the snapshot */
+    UA_AddReferencesItem *external = NULL;
+    size_t externalSize = 0;
+    size_t externalCapacity = 0;
+
+    UA_RCU_LOCK();
+    for(UA_UInt32 i = 0; i < count && retval == UA_STATUSCODE_GOOD; ++i) {
+        UA_Node *node = NULL;
+        retval = restoreNode(src, &offset, &node);
+        if(retval != UA_STATUSCODE_GOOD)
+            break;
+
+        for(size_t j = 0; j < node->referencesSize && retval == UA_STATUSCODE_GOOD; ++j) {
+            UA_ReferenceNode *ref = &node->references[j];
+            UA_Boolean outside = (ref->targetId.nodeId.namespaceIndex != node->nodeId.namespaceIndex);
+            for(size_t k = 0; k < remapSize; ++k) {
+                if(UA_NodeId_equal(&ref->targetId.nodeId, &remapFrom[k])) {
+                    UA_NodeId_deleteMembers(&ref->targetId.nodeId);
+                    retval = UA_NodeId_copy(&remapTo[k], &ref->targetId.nodeId);
+                    outside = true;
+                    break;
+                }
+            }
+            if(!outside || retval != UA_STATUSCODE_GOOD)
+                continue;
+            if(externalSize == externalCapacity) {
+                size_t capacity = externalCapacity > 0 ? externalCapacity * 2 : 64;
+                UA_AddReferencesItem *items = UA_realloc(external, sizeof(UA_AddReferencesItem) * capacity);
+                if(!items) {
+                    retval = UA_STATUSCODE_BADOUTOFMEMORY;
+                    break;
+                }
+                external = items;
+                externalCapacity = capacity;
+            }
+            UA_AddReferencesItem *item = &external[externalSize++];
+            UA_AddReferencesItem_init(item);
+            retval |= UA_NodeId_copy(&ref->targetId.nodeId, &item->sourceNodeId);
+            retval |= UA_NodeId_copy(&ref->referenceTypeId, &item->referenceTypeId);
+            retval |= UA_NodeId_copy(&node->nodeId, &item->targetNodeId.nodeId);
+            item->isForward = ref->isInverse;
+        }
+        if(retval == UA_STATUSCODE_GOOD)
+            retval = UA_NodeId_copy(&node->nodeId, &inserted[insertedSize]);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_NodeStore_deleteNode(node);
+            break;
+        }
+        /* Deletes the node if the NodeId exists */
+        retval = UA_NodeStore_insert(server->nodestore, node);
+        if(retval != UA_STATUSCODE_GOOD)
+            UA_NodeId_deleteMembers(&inserted[insertedSize]);
+        else
+            ++insertedSize;
+    }
+
+    /* Every node outside of the snapshot has to exist, before any of them is changed */
+    for(size_t i = 0; i < externalSize && retval == UA_STATUSCODE_GOOD; ++i) {
+        if(!UA_NodeStore_get(server->nodestore, &external[i].sourceNodeId))
+            retval = UA_STATUSCODE_BADNODEIDUNKNOWN;
+    }
+
+    /* One edit per node outside of the snapshot, its references are grouped by sorting */
+    size_t edited = 0; /* external[0..edited) went to nodes which were edited */
+    if(retval == UA_STATUSCODE_GOOD && externalSize > 0) {
+        qsort(external, externalSize, sizeof(UA_AddReferencesItem), compareRestoredReferences);
+        size_t first = 0;
+        for(size_t i = 1; i <= externalSize && retval == UA_STATUSCODE_GOOD; ++i) {
+            if(i < externalSize && UA_NodeId_equal(&external[i].sourceNodeId, &external[first].sourceNodeId))
+                continue;
+            UA_RestoredReferences restored = {&external[first], i - first};
+            retval = UA_Server_editNode(server, &adminSession, &external[first].sourceNodeId,
+                                        (UA_EditNodeCallback)addRestoredReferences, &restored);
+            /* A failed edit may have added some of its references as well */
+            edited = i;
+            first = i;
+        }
+    }
+
+    if(retval != UA_STATUSCODE_GOOD) {
+        /* Nodes outside of the snapshot must not point to the removed nodes */
+        size_t first = 0;
+        for(size_t i = 1; i <= edited; ++i) {
+            if(i < edited && UA_NodeId_equal(&external[i].sourceNodeId, &external[first].sourceNodeId))
+                continue;
+            UA_RestoredReferences restored = {&external[first], i - first};
+            UA_Server_editNode(server, &adminSession, &external[first].sourceNodeId,
+                               (UA_EditNodeCallback)removeRestoredReferences, &restored);
+            first = i;
+        }
+        for(size_t i = 0; i < insertedSize; ++i)
+            UA_NodeStore_remove(server->nodestore, &inserted[i]);
+    }
+    UA_RCU_UNLOCK();
+
+    for(size_t i = 0; i < insertedSize; ++i)
+        UA_NodeId_deleteMembers(&inserted[i]);
+    UA_free(inserted);
+    for(size_t i = 0; i < externalSize; ++i)
+        UA_AddReferencesItem_deleteMembers(&external[i]);
+    UA_free(external);
+    return retval;
+}
+
 /****************************/
 /* Set Lifecycle Management */
 /****************************/
@@ -22753,6 +23321,8 @@ Service_Browse_single(UA_Server *server, UA_Session *session,
         descr = &cp->browseDescription;
         maxrefs = cp->maxReferences;
         continuationIndex = cp->continuationIndex;
+    } else if(server->nodeAccessCallback.onAccess) {
+        server->nodeAccessCallback.onAccess(server->nodeAccessCallback.handle, &descr->nodeId);
     }
 
     /* is the browsedirection valid? */
@@ -23084,6 +23654,57 @@ walkBrowsePath(UA_Server *server, UA_Session *session, const UA_Node *node, cons
     return retval;
 }
 
+/* Announces every node on the browse path before the path is walked. The
+ * callback may replace nodes in the nodestore, so only NodeIds are kept between
+ * the calls. The reference types are not checked, a superset of the walked
+ * nodes is announced. */
+static void
+announceBrowsePath(UA_Server *server, const UA_BrowsePath *path) {
+    UA_NodeId *ids = UA_malloc(sizeof(UA_NodeId));
+    if(!ids)
+        return;
+    size_t idsSize = 1;
+    if(UA_NodeId_copy(&path->startingNode, ids) != UA_STATUSCODE_GOOD) {
+        UA_free(ids);
+        return;
+    }
+
+    for(size_t i = 0; i < path->relativePath.elementsSize && idsSize > 0; ++i) {
+        const UA_RelativePathElement *elem = &path->relativePath.elements[i];
+        UA_NodeId *next = NULL;
+        size_t nextSize = 0;
+        for(size_t j = 0; j < idsSize; ++j) {
+            server->nodeAccessCallback.onAccess(server->nodeAccessCallback.handle, &ids[j]);
+            const UA_Node *node = UA_NodeStore_get(server->nodestore, &ids[j]);
+            if(!node)
+                continue;
+            for(size_t k = 0; k < node->referencesSize; ++k) {
+                if(node->references[k].isInverse != elem->isInverse)
+                    continue;
+                const UA_Node *target = UA_NodeStore_get(server->nodestore, &node->references[k].targetId.nodeId);
+                if(!target || elem->targetName.namespaceIndex != target->browseName.namespaceIndex ||
+                   !UA_String_equal(&elem->targetName.name, &target->browseName.name))
+                    continue;
+                UA_NodeId *newNext = UA_realloc(next, sizeof(UA_NodeId) * (nextSize + 1));
+                if(!newNext)
+                    continue;
+                next = newNext;
+                if(UA_NodeId_copy(&target->nodeId, &next[nextSize]) == UA_STATUSCODE_GOOD)
+                    ++nextSize;
+            }
+        }
+        for(size_t j = 0; j < idsSize; ++j)
+            UA_NodeId_deleteMembers(&ids[j]);
+        UA_free(ids);
+        ids = next;
+        idsSize = nextSize;
+    }
+
+    for(size_t j = 0; j < idsSize; ++j)
+        UA_NodeId_deleteMembers(&ids[j]);
+    UA_free(ids);
+}
+
 void Service_TranslateBrowsePathsToNodeIds_single(UA_Server *server, UA_Session *session,
                                                   const UA_BrowsePath *path, UA_BrowsePathResult *result) {
     if(path->relativePath.elementsSize <= 0) {
@@ -23107,6 +23728,8 @@ void Service_TranslateBrowsePathsToNodeIds_single(UA_Server *server, UA_Session
         return;
     }
     result->targetsSize = 0;
+    if(server->nodeAccessCallback.onAccess)
+        announceBrowsePath(server, path);
     const UA_Node *firstNode = UA_NodeStore_get(server->nodestore, &path->startingNode);
     if(!firstNode) {
         result->statusCode = UA_STATUSCODE_BADNODEIDUNKNOWN;
@@ -23424,6 +24047,8 @@ void Service_Call(UA_Server *server, UA_Session *session,
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS /* conditional compilation */
 
+#include <math.h>
+
 #define UA_VALUENCODING_MAXSTACK 512
 
 /*****************/
@@ -23441,13 +24066,66 @@ UA_MonitoredItem * UA_MonitoredItem_new() {
     TAILQ_INIT(&new->queue);
     UA_NodeId_init(&new->monitoredNodeId);
     new->lastSampledValue = UA_BYTESTRING_NULL;
+    UA_Variant_init(&new->lastReportedValue);
+    new->lastReportedStatus = UA_STATUSCODE_GOOD;
+    new->trigger = UA_DATACHANGETRIGGER_STATUSVALUE;
+    new->deadbandType = UA_DEADBANDTYPE_NONE;
+    new->deadbandValue = 0.0;
     memset(&new->sampleJobGuid, 0, sizeof(UA_Guid));
     new->sampleJobIsRegistered = false;
     new->itemId = 0;
+    new->indexed = false;
     return new;
 }
 
+#define UA_MONITOREDITEMINDEX_MINSIZE 64
+
+void MonitoredItem_addToIndex(UA_Server *server, UA_MonitoredItem *mon) {
+    UA_MonitoredItemIndex *index = &server->monitoredItemIndex;
+
+    /* Grow with the number of items, so the chains stay short. If that fails,
+     * the chains of the old buckets get longer. */
+    if(index->count >= index->bucketsSize) {
+        size_t size = index->bucketsSize > 0 ?
+            index->bucketsSize * 2 : UA_MONITOREDITEMINDEX_MINSIZE;
+        struct UA_MonitoredItemBucket *buckets =
+            UA_malloc(sizeof(struct UA_MonitoredItemBucket) * size);
+        if(buckets) {
+            for(size_t i = 0; i < size; ++i)
+                LIST_INIT(&buckets[i]);
+            for(size_t i = 0; i < index->bucketsSize; ++i) {
+                UA_MonitoredItem *item, *item_tmp;
+                LIST_FOREACH_SAFE(item, &index->buckets[i], indexEntry, item_tmp) {
+                    LIST_REMOVE(item, indexEntry);
+                    LIST_INSERT_HEAD(&buckets[UA_NodeId_hash(&item->monitoredNodeId) % size],
+                                     item, indexEntry);
+                }
+            }
+            UA_free(index->buckets);
+            index->buckets = buckets;
+            index->bucketsSize = size;
+        }
+    }
+
+    /* Without buckets the item is only sampled */
+    if(index->bucketsSize == 0)
+        return;
+    LIST_INSERT_HEAD(&index->buckets[UA_NodeId_hash(&mon->monitoredNodeId) % index->bucketsSize],
+                     mon, indexEntry);
+    mon->indexed = true;
+    ++index->count;
+}
+
+void MonitoredItem_removeFromIndex(UA_Server *server, UA_MonitoredItem *mon) {
+    if(!mon->indexed)
+        return;
+    LIST_REMOVE(mon, indexEntry);
+    mon->indexed = false;
+    --server->monitoredItemIndex.count;
+}
+
 void MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *monitoredItem) {
+    MonitoredItem_removeFromIndex(server, monitoredItem);
     MonitoredItem_unregisterSampleJob(server, monitoredItem);
     /* clear the queued samples */
     MonitoredItem_queuedValue *val, *val_tmp;
@@ -23460,6 +24138,7 @@ void MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *monitoredItem) {
     LIST_REMOVE(monitoredItem, listEntry);
     UA_String_deleteMembers(&monitoredItem->indexRange);
     UA_ByteString_deleteMembers(&monitoredItem->lastSampledValue);
+    UA_Variant_deleteMembers(&monitoredItem->lastReportedValue);
     UA_NodeId_deleteMembers(&monitoredItem->monitoredNodeId);
     UA_free(monitoredItem);
 }
@@ -23482,6 +24161,67 @@ ensureSpaceInMonitoredItemQueue(UA_MonitoredItem *mon) {
 
 /* Has this sample changed from the last one? The method may allocate additional
  * space for the encoding buffer. Detect the change in encoding->data. */
+/* Compare all elements against the last reported value. The loops do not
+ * branch, so the compiler can vectorize them for large arrays. */
+#define UA_DEADBAND_EXCEEDED(TYPE)                                          \
+static UA_Boolean                                                           \
+deadbandExceeded_##TYPE(const TYPE *v, const TYPE *last, size_t size,       \
+                        UA_Double absolute, UA_Double relative) {           \
+    UA_Boolean exceeded = false;                                            \
+    for(size_t i = 0; i < size; ++i) {                                      \
+        UA_Double diff = fabs((UA_Double)v[i] - (UA_Double)last[i]);        \
+        exceeded |= (diff > absolute + relative * fabs((UA_Double)last[i])); \
+    }                                                                       \
+    return exceeded;                                                        \
+}
+
+UA_DEADBAND_EXCEEDED(UA_SByte)
+UA_DEADBAND_EXCEEDED(UA_Byte)
+UA_DEADBAND_EXCEEDED(UA_Int16)
+UA_DEADBAND_EXCEEDED(UA_UInt16)
+UA_DEADBAND_EXCEEDED(UA_Int32)
+UA_DEADBAND_EXCEEDED(UA_UInt32)
+UA_DEADBAND_EXCEEDED(UA_Int64)
+UA_DEADBAND_EXCEEDED(UA_UInt64)
+UA_DEADBAND_EXCEEDED(UA_Float)
+UA_DEADBAND_EXCEEDED(UA_Double)
+
+/* Is the sampled value outside the deadband around the last reported value?
+ * Evaluated before the value is encoded for the change detection. Percent
+ * deadbands are relative to the last reported value, since the nodes carry
+ * no EURange. Status, type and length changes are always reported. */
+static UA_Boolean
+outsideDeadband(const UA_MonitoredItem *mon, const UA_DataValue *value) {
+    const UA_Variant *last = &mon->lastReportedValue;
+    UA_StatusCode status = value->hasStatus ? value->status : UA_STATUSCODE_GOOD;
+    if(!value->hasValue || !last->type || status != mon->lastReportedStatus ||
+       value->value.type != last->type || value->value.arrayLength != last->arrayLength ||
+       !value->value.data || !last->data)
+        return true;
+
+    size_t size = UA_Variant_isScalar(last) ? 1 : last->arrayLength;
+    UA_Double absolute = 0.0, relative = 0.0;
+    if(mon->deadbandType == UA_DEADBANDTYPE_PERCENT)
+        relative = mon->deadbandValue / 100.0;
+    else
+        absolute = mon->deadbandValue;
+
+    const void *v = value->value.data;
+    switch(last->type->typeIndex) {
+    case UA_TYPES_SBYTE: return deadbandExceeded_UA_SByte(v, last->data, size, absolute, relative);
+    case UA_TYPES_BYTE: return deadbandExceeded_UA_Byte(v, last->data, size, absolute, relative);
+    case UA_TYPES_INT16: return deadbandExceeded_UA_Int16(v, last->data, size, absolute, relative);
+    case UA_TYPES_UINT16: return deadbandExceeded_UA_UInt16(v, last->data, size, absolute, relative);
+    case UA_TYPES_INT32: return deadbandExceeded_UA_Int32(v, last->data, size, absolute, relative);
+    case UA_TYPES_UINT32: return deadbandExceeded_UA_UInt32(v, last->data, size, absolute, relative);
+    case UA_TYPES_INT64: return deadbandExceeded_UA_Int64(v, last->data, size, absolute, relative);
+    case UA_TYPES_UINT64: return deadbandExceeded_UA_UInt64(v, last->data, size, absolute, relative);
+    case UA_TYPES_FLOAT: return deadbandExceeded_UA_Float(v, last->data, size, absolute, relative);
+    case UA_TYPES_DOUBLE: return deadbandExceeded_UA_Double(v, last->data, size, absolute, relative);
+    default: return true; /* Deadbands apply to numeric values only */
+    }
+}
+
 static UA_StatusCode
 detectValueChange(UA_MonitoredItem *mon, UA_DataValue *value,
                   UA_ByteString *encoding, UA_Boolean *changed) {
@@ -23564,6 +24304,15 @@ void UA_MoniteredItem_SampleCallback(UA_Server *server, UA_MonitoredItem *monito
     UA_DataValue_init(&value);
     Service_Read_single(server, sub->session, ts, &rvid, &value);
 
+    /* Deadbands apply to the value trigger only, new source timestamps are
+     * reported with UA_DATACHANGETRIGGER_STATUSVALUETIMESTAMP anyway */
+    UA_Boolean deadband = (monitoredItem->deadbandType != UA_DEADBANDTYPE_NONE &&
+                           monitoredItem->trigger == UA_DATACHANGETRIGGER_STATUSVALUE);
+    if(deadband && !outsideDeadband(monitoredItem, &value)) {
+        UA_DataValue_deleteMembers(&value);
+        return;
+    }
+
     /* Stack-allocate some memory for the value encoding */
     UA_Byte *stackValueEncoding = UA_alloca(UA_VALUENCODING_MAXSTACK);
     UA_ByteString valueEncoding;
@@ -23626,6 +24375,16 @@ void UA_MoniteredItem_SampleCallback(UA_Server *server, UA_MonitoredItem *monito
     UA_ByteString_deleteMembers(&monitoredItem->lastSampledValue);
     monitoredItem->lastSampledValue = valueEncoding;
 
+    /* Keep the reported value as reference for the deadband. If the copy
+     * fails, the next sample is reported unconditionally. */
+    if(deadband) {
+        UA_Variant_deleteMembers(&monitoredItem->lastReportedValue);
+        if(newQueueItem->value.hasValue)
+            UA_Variant_copy(&newQueueItem->value.value, &monitoredItem->lastReportedValue);
+        monitoredItem->lastReportedStatus = newQueueItem->value.hasStatus ?
+            newQueueItem->value.status : UA_STATUSCODE_GOOD;
+    }
+
     /* Add the sample to the queue for publication */
     ensureSpaceInMonitoredItemQueue(monitoredItem);
     TAILQ_INSERT_TAIL(&monitoredItem->queue, newQueueItem, listEntry);
@@ -23659,6 +24418,22 @@ UA_StatusCode MonitoredItem_unregisterSampleJob(UA_Server *server, UA_MonitoredI
     return UA_Server_removeRepeatedJob(server, mon->sampleJobGuid);
 }
 
+UA_StatusCode
+UA_Server_triggerMonitoredItems(UA_Server *server, const UA_NodeId nodeId) {
+    UA_MonitoredItemIndex *index = &server->monitoredItemIndex;
+    if(index->bucketsSize == 0)
+        return UA_STATUSCODE_GOOD;
+    UA_MonitoredItem *mon;
+    LIST_FOREACH(mon, &index->buckets[UA_NodeId_hash(&nodeId) % index->bucketsSize], indexEntry) {
+        if(mon->monitoringMode != UA_MONITORINGMODE_REPORTING ||
+           !UA_NodeId_equal(&mon->monitoredNodeId, &nodeId))
+            continue;
+        /* The regular sample detects whether the value has changed */
+        UA_MoniteredItem_SampleCallback(server, mon);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 /****************/
 /* Subscription */
 /****************/
@@ -24188,14 +24963,32 @@ setMonitoredItemSettings(UA_Server *server, UA_MonitoredItem *mon,
         mon->samplingInterval = server->config.samplingIntervalLimits.min;
 
     /* Filter */
-    if(params->filter.encoding != UA_EXTENSIONOBJECT_DECODED ||
-       params->filter.content.decoded.type != &UA_TYPES[UA_TYPES_DATACHANGEFILTER]) {
-        /* Default: Trigger only on the value and the statuscode */
-        mon->trigger = UA_DATACHANGETRIGGER_STATUSVALUE;
-    } else {
+    /* Default: Trigger only on the value and the statuscode */
+    mon->trigger = UA_DATACHANGETRIGGER_STATUSVALUE;
+    mon->deadbandType = UA_DEADBANDTYPE_NONE;
+    mon->deadbandValue = 0.0;
+    if(params->filter.encoding == UA_EXTENSIONOBJECT_DECODED &&
+       params->filter.content.decoded.type == &UA_TYPES[UA_TYPES_DATACHANGEFILTER]) {
         UA_DataChangeFilter *filter = params->filter.content.decoded.data;
         mon->trigger = filter->trigger;
+        mon->deadbandType = (UA_DeadbandType)filter->deadbandType;
+        mon->deadbandValue = filter->deadbandValue;
     }
+    /* Without a deadband of its own (or without any filter), the client gets
+     * the deadband of the node */
+    if(mon->deadbandType == UA_DEADBANDTYPE_NONE &&
+       mon->attributeID == UA_ATTRIBUTEID_VALUE) {
+        const UA_VariableNode *vn = (const UA_VariableNode*)
+            UA_NodeStore_get(server->nodestore, &mon->monitoredNodeId);
+        if(vn && vn->nodeClass == UA_NODECLASS_VARIABLE) {
+            mon->deadbandType = vn->deadbandType;
+            mon->deadbandValue = vn->deadbandValue;
+        }
+    }
+    if(mon->deadbandType > UA_DEADBANDTYPE_PERCENT ||
+       !(mon->deadbandValue > 0.0)) /* Also catches nan */
+        mon->deadbandType = UA_DEADBANDTYPE_NONE;
+    UA_Variant_deleteMembers(&mon->lastReportedValue);
 
     /* QueueSize */
     UA_BOUNDEDVALUE_SETWBOUNDS(server->config.queueSizeLimits,
@@ -24268,6 +25061,8 @@ Service_CreateMonitoredItems_single(UA_Server *server, UA_Session *session,
     setMonitoredItemSettings(server, newMon, request->monitoringMode,
                              &request->requestedParameters);
     LIST_INSERT_HEAD(&sub->monitoredItems, newMon, listEntry);
+    if(newMon->attributeID == UA_ATTRIBUTEID_VALUE)
+        MonitoredItem_addToIndex(server, newMon);
 
     /* Create the first sample */
     if(request->monitoringMode == UA_MONITORINGMODE_REPORTING)
@@ -26434,7 +27229,9 @@ typedef struct {
     struct ConnectionMapping {
         UA_Connection *connection;
         UA_Int32 sockfd;
+        UA_UInt64 generation; /* Tells connections apart which reuse a sockfd */
     } *mappings;
+    UA_UInt64 acceptedConnections;
 } ServerNetworkLayerTCP;
 
 static UA_StatusCode
@@ -26533,6 +27330,7 @@ ServerNetworkLayerTCP_add(ServerNetworkLayerTCP *layer, UA_Int32 newsockfd) {
     layer->mappings = nm;
     layer->mappings[layer->mappingsSize].connection = c;
     layer->mappings[layer->mappingsSize].sockfd = newsockfd;
+    layer->mappings[layer->mappingsSize].generation = ++layer->acceptedConnections;
     ++layer->mappingsSize;
     return UA_STATUSCODE_GOOD;
 }
@@ -26748,6 +27546,26 @@ UA_ServerNetworkLayerTCP(UA_ConnectionConfig conf, UA_UInt16 port) {
     return nl;
 }
 
+size_t
+UA_ServerNetworkLayerTCP_getSockets(const UA_ServerNetworkLayer *nl,
+                                    UA_Int32 *sockets, UA_UInt64 *generations,
+                                    size_t socketsSize) {
+    const ServerNetworkLayerTCP *layer = nl->handle;
+    if(socketsSize > 0) {
+        if(sockets)
+            sockets[0] = layer->serversockfd;
+        if(generations)
+            generations[0] = 0;
+    }
+    for(size_t i = 0; i < layer->mappingsSize && i + 1 < socketsSize; ++i) {
+        if(sockets)
+            sockets[i + 1] = layer->mappings[i].sockfd;
+        if(generations)
+            generations[i + 1] = layer->mappings[i].generation;
+    }
+    return layer->mappingsSize + 1;
+}
+
 /***************************/
 /* Client NetworkLayer TCP */
 /***************************/
@@ -28,6 +28,22 @@ extern "C" {
 #include <thread>
 #include <future>
 #include <functional>     // std::ref
+#include <unordered_set>
+#include <unordered_map>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#include <boost/algorithm/string.hpp>
+#include <libxml2/libxml/xmlreader.h>
 
 #include "csa_config.h"
 
@@ -46,9 +62,26 @@ extern "C" {
 using namespace ChimeraTK;
 using namespace std;
 
+#define UA_ADAPTER_SNAPSHOT_MAGIC   0x53415343
+#define UA_ADAPTER_SNAPSHOT_VERSION 1
+
+#define UA_ADAPTER_LOOP_EVENTS 64
+// Timeout of the server loop in ms while a socket or the timer cannot be watched
+#define UA_ADAPTER_LOOP_POLL_MS 50
+
+static void ua_uaadapter_accessNode(void *handle, const UA_NodeId *nodeId) {
+        static_cast<ua_uaadapter *>(handle)->accessNode(*nodeId);
+}
+
 ua_uaadapter::ua_uaadapter(string configFile) : ua_mapped_class() {
-        this->fileHandler = new xml_file_handler(configFile);
-        this->readConfig();
+        this->configPath = configFile;
+        this->filteredCount = 0;
+        this->deferredCount = 0;
+        this->committingDeferred = false;
+        this->recordSnapshotNodes = false;
+        this->restoredFromSnapshot = false;
+        this->wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        this->readConfig(configFile);
 
         this->constructServer();
 
@@ -64,11 +97,21 @@ ua_uaadapter::~ua_uaadapter() {
         if (this->isRunning()) {
                 this->doStop();
         }
+        if(this->wakeupFd >= 0) {
+                close(this->wakeupFd);
+        }
         //UA_Server_delete(this->mappedServer);
-        this->fileHandler->~xml_file_handler();
         for(auto ptr : variables) delete ptr;
         for(auto ptr : additionalVariables) delete ptr;
         for(auto ptr : mappedVariables) delete ptr;
+        for(auto folder : folderIndex) {
+                UA_NodeId parentKey = folder.first;
+                UA_NodeId_deleteMembers(&parentKey);
+        }
+        for(auto deferredChildren : deferredByParent) {
+                UA_NodeId parentKey = deferredChildren.first;
+                UA_NodeId_deleteMembers(&parentKey);
+        }
 
 }
 
@@ -100,333 +143,1092 @@ void ua_uaadapter::constructServer() {
                 this->baseNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
 
                 csa_namespaceinit_generated(this->mappedServer);
+
+                // Collect the process variable writes of every client WriteRequest and send them together
+                this->writeBatch.setAtomic(this->serverConfig.atomicWrites);
+                this->writeBatch.attach(this->mappedServer);
+
+                // Commit the deferred variables when a client first browses or reads them
+                if(this->serverConfig.lazyInstantiation) {
+                        UA_NodeAccessCallback accessCallback;
+                        accessCallback.handle = this;
+                        accessCallback.onAccess = ua_uaadapter_accessNode;
+                        UA_Server_setNodeAccessCallback(this->mappedServer, accessCallback);
+                }
 }
 
-void ua_uaadapter::readConfig() {
+static string ua_uaadapter_readAttribute(xmlTextReaderPtr reader, const char *attributeName) {
+        xmlChar *value = xmlTextReaderGetAttribute(reader, (const xmlChar *) attributeName);
+        if(value == NULL) {
+                return "";
+        }
+        string merker = (char *) value;
+        xmlFree(value);
+        return merker;
+}
+
+static string ua_uaadapter_readContent(xmlTextReaderPtr reader) {
+        xmlChar *content = xmlTextReaderReadString(reader);
+        if(content == NULL) {
+                return "";
+        }
+        string merker = (char *) content;
+        xmlFree(content);
+        boost::trim(merker);
+        return merker;
+}
 
-        string xpath = "//config";
-        xmlXPathObjectPtr result = this->fileHandler->getNodeSet(xpath);
-        string placeHolder = "";
-        if(result) {
-                xmlNodeSetPtr nodeset = result->nodesetval;
-                // There should be only one <config>-Tag in config file
-                if(nodeset->nodeNr > 1) {
-                        //cout << "More than one <config>-Tag was found in config file. Please provide only one Tag." << endl;
-                        throw std::runtime_error ("To many <config>-Tags in config file");
+void ua_uaadapter::readConfig(string configFile) {
+        xmlTextReaderPtr reader = NULL;
+        if(!configFile.empty()) {
+                reader = xmlReaderForFile(configFile.c_str(), NULL, 0);
+                if(reader == NULL) {
+                        std::cout << "Document not parsed successfully." << std::endl;
+                        exit(0);
                 }
+        }
+
+        // Local name of every open element, the stack is cut back to the depth of each new element
+        vector<string> openElements;
+        // Name attribute of every open element, a <map>-tag takes the name of its <application>-tag
+        vector<string> openNames;
+        size_t configCount = 0;
+        bool loginFound = false;
+        bool serverConfigFound = false;
+        bool inMap = false;
+        vector<string> mapFolders;
+        MapEntry entry;
+        string matchMode;
+
+        int readStatus = reader ? xmlTextReaderRead(reader) : 0;
+        for(; readStatus == 1; readStatus = xmlTextReaderRead(reader)) {
+                int nodeType = xmlTextReaderNodeType(reader);
+                bool mapDone = false;
+                if(nodeType == XML_READER_TYPE_ELEMENT) {
+                        size_t depth = xmlTextReaderDepth(reader);
+                        string name = (const char *) xmlTextReaderConstLocalName(reader);
+                        openElements.resize(depth);
+                        openNames.resize(depth);
+                        string parent = openElements.empty() ? "" : openElements.back();
+                        string parentName = openNames.empty() ? "" : openNames.back();
+                        bool inConfig = find(openElements.begin(), openElements.end(), "config") != openElements.end();
+                        openElements.push_back(name);
+                        openNames.push_back(ua_uaadapter_readAttribute(reader, "name"));
+
+                        if(name == "config") {
+                                // There should be only one <config>-Tag in config file
+                                if(++configCount > 1) {
+                                        break;
+                                }
+                                string placeHolder = ua_uaadapter_readAttribute(reader, "rootFolder");
+                                if(!placeHolder.empty()) {
+                                        this->serverConfig.rootFolder = placeHolder;
+                                }
+                                placeHolder = ua_uaadapter_readAttribute(reader, "description");
+                                if(!placeHolder.empty()) {
+                                        this->serverConfig.descriptionFolder = placeHolder;
+                                }
+                        }
+                        else if(name == "login" && inConfig && !loginFound) {
+                                loginFound = true;
+                                string placeHolder = ua_uaadapter_readAttribute(reader, "password");
+                                if(!placeHolder.empty()) {
+                                        this->serverConfig.password = placeHolder;
+                                }
+                                placeHolder = ua_uaadapter_readAttribute(reader, "username");
+                                if(!placeHolder.empty()) {
+                                        this->serverConfig.username = placeHolder;
+                                }
+                        }
+                        else if(name == "serverConfig" && inConfig && !serverConfigFound) {
+                                serverConfigFound = true;
+                                string opcuaPort = ua_uaadapter_readAttribute(reader, "port");
+                                if(opcuaPort.compare("") != 0) {
+                                        this->serverConfig.opcuaPort = std::stoi(opcuaPort);
+                                }
+                                else {
+                                        cout << "No 'port'-Attribute in config file is set. Use default Port: 16664" << endl;
+                                }
+
+                                string placeHolder = ua_uaadapter_readAttribute(reader, "applicationName");
+                                if(placeHolder.compare("") != 0) {
+                                        this->serverConfig.applicationName = placeHolder;
+                                }
+                                else {
+                                        cout << "No 'applicationName'-Attribute is set in config file. Use default Applicationname." << endl;
+                                }
+
+                                placeHolder = ua_uaadapter_readAttribute(reader, "zeroCopyArrays");
+                                if(placeHolder.compare("True") == 0 || placeHolder.compare("true") == 0) {
+                                        this->serverConfig.zeroCopyArrays = true;
+                                }
 
-                placeHolder = this->fileHandler->getAttributeValueFromNode(nodeset->nodeTab[0], "rootFolder");
-                if(!placeHolder.empty()) {
-                        this->serverConfig.rootFolder = placeHolder;
+                                placeHolder = ua_uaadapter_readAttribute(reader, "atomicWrites");
+                                if(placeHolder.compare("True") == 0 || placeHolder.compare("true") == 0) {
+                                        this->serverConfig.atomicWrites = true;
+                                }
+
+                                placeHolder = ua_uaadapter_readAttribute(reader, "updatePump");
+                                if(placeHolder.compare("True") == 0 || placeHolder.compare("true") == 0) {
+                                        this->serverConfig.updatePump = true;
+                                }
+
+                                placeHolder = ua_uaadapter_readAttribute(reader, "lazyInstantiation");
+                                if(placeHolder.compare("True") == 0 || placeHolder.compare("true") == 0) {
+                                        this->serverConfig.lazyInstantiation = true;
+                                }
+
+                                this->serverConfig.snapshotFile = ua_uaadapter_readAttribute(reader, "snapshotFile");
+                        }
+                        else if((name == "include" || name == "exclude") && inConfig) {
+                                ua_map_matcher &filter = name == "include" ? this->includeFilter : this->excludeFilter;
+                                string pattern = ua_uaadapter_readContent(reader);
+                                if(ua_uaadapter_readAttribute(reader, "match").compare("regex") == 0) {
+                                        try {
+                                                filter.addRegex(pattern);
+                                        }
+                                        catch(std::regex_error &e) {
+                                                cout << "Pattern '" << pattern << "' is no valid regex, ignore <" << name << ">-Element." << endl;
+                                        }
+                                }
+                                else {
+                                        filter.addGlob(pattern);
+                                }
+                        }
+                        else if(name == "additionalNodes") {
+                                AdditionalNodesEntry additional;
+                                additional.folderName = ua_uaadapter_readAttribute(reader, "folderName");
+                                additional.description = ua_uaadapter_readAttribute(reader, "description");
+                                this->additionalNodes.push_back(additional);
+                        }
+                        else if(name == "variable" && parent == "additionalNodes") {
+                                AdditionalVariableEntry variable;
+                                variable.name = ua_uaadapter_readAttribute(reader, "name");
+                                variable.value = ua_uaadapter_readAttribute(reader, "value");
+                                variable.description = ua_uaadapter_readAttribute(reader, "description");
+                                this->additionalNodes.back().variables.push_back(variable);
+                        }
+                        else if(name == "map") {
+                                entry = MapEntry();
+                                mapFolders.clear();
+                                entry.sourceVariableName = ua_uaadapter_readAttribute(reader, "sourceVariableName");
+                                // get name attribute from <application>-tag
+                                entry.applicationName = parentName;
+                                entry.rename = ua_uaadapter_readAttribute(reader, "rename");
+                                entry.engineeringUnit = ua_uaadapter_readAttribute(reader, "engineeringUnit");
+                                entry.description = ua_uaadapter_readAttribute(reader, "description");
+                                entry.deadbandAbsolute = ua_uaadapter_readAttribute(reader, "deadbandAbsolute");
+                                entry.deadbandRelative = ua_uaadapter_readAttribute(reader, "deadbandRelative");
+                                if(!ua_uaadapter_readAttribute(reader, "deadbandPercent").empty()) {
+                                        cout << "Attribute 'deadbandPercent' of variable '" << entry.sourceVariableName << "' is not supported, use 'deadbandRelative' for a deadband relative to the last reported value." << endl;
+                                }
+                                matchMode = ua_uaadapter_readAttribute(reader, "match");
+                                inMap = true;
+                                mapDone = xmlTextReaderIsEmptyElement(reader);
+                        }
+                        else if(name == "unrollPath" && inMap && parent == "map") {
+                                if(ua_uaadapter_readContent(reader).compare("True") == 0) {
+                                        entry.unrollPathSeparator = entry.unrollPathSeparator + ua_uaadapter_readAttribute(reader, "pathSep");
+                                        entry.unrollPath = true;
+                                }
+                        }
+                        else if(name == "folder" && inMap && parent == "map") {
+                                // The folders are resolved at the end of the <map>-tag, when all <unrollPath>-tags are known
+                                mapFolders.push_back(ua_uaadapter_readContent(reader));
+                        }
+                }
+                else if(nodeType == XML_READER_TYPE_END_ELEMENT && inMap && xmlStrEqual(xmlTextReaderConstLocalName(reader), (const xmlChar *) "map")) {
+                        mapDone = true;
                 }
 
-                placeHolder = this->fileHandler->getAttributeValueFromNode(nodeset->nodeTab[0], "description");
-                if(!placeHolder.empty()) {
-                        this->serverConfig.descriptionFolder = placeHolder;
+                if(mapDone) {
+                        inMap = false;
+                        for(const string &folderPath : mapFolders) {
+                                if(folderPath.empty() && entry.unrollPath) {
+                                        break;
+                                }
+                                if(matchMode.empty()) {
+                                        entry.folderPaths.push_back(xml_file_handler::praseVariablePath(folderPath));
+                                }
+                                else {
+                                        entry.folderTemplates.push_back(folderPath);
+                                }
+                        }
+
+                        if(matchMode.empty()) {
+                                this->mapIndex[entry.sourceVariableName].push_back(this->mapEntries.size());
+                        }
+                        else if(matchMode.compare("glob") == 0) {
+                                entry.pattern = true;
+                                this->mapMatcher.addGlob(entry.sourceVariableName);
+                                this->patternEntries.push_back(this->mapEntries.size());
+                        }
+                        else if(matchMode.compare("regex") == 0) {
+                                entry.pattern = true;
+                                try {
+                                        this->mapMatcher.addRegex(entry.sourceVariableName);
+                                }
+                                catch(std::regex_error &e) {
+                                        cout << "Pattern '" << entry.sourceVariableName << "' is no valid regex, ignore <map>-Element." << endl;
+                                        continue;
+                                }
+                                this->patternEntries.push_back(this->mapEntries.size());
+                        }
+                        else {
+                                cout << "Unknown match '" << matchMode << "' of <map>-Element '" << entry.sourceVariableName << "', ignore it. Use 'glob' or 'regex'." << endl;
+                                continue;
+                        }
+                        this->mapEntries.push_back(entry);
                 }
         }
 
-        result = this->fileHandler->getNodeSet(xpath + "//login");
-        if(result) {
-                xmlNodeSetPtr nodeset = result->nodesetval;
-                this->serverConfig.UsernamePasswordLogin = UA_TRUE;
-                placeHolder = this->fileHandler->getAttributeValueFromNode(nodeset->nodeTab[0], "password");
-                if(!placeHolder.empty()) {
-                        this->serverConfig.password = placeHolder;
+        // Release the reader and the parser buffers before anything is thrown
+        if(reader != NULL) {
+                xmlFreeTextReader(reader);
+        }
+        if(configCount > 1) {
+                throw std::runtime_error ("To many <config>-Tags in config file");
+        }
+        if(readStatus < 0) {
+                std::cout << "Document not parsed successfully." << std::endl;
+                exit(0);
+        }
+        this->mapEntries.shrink_to_fit();
+
+        this->serverConfig.UsernamePasswordLogin = loginFound ? UA_TRUE : UA_FALSE;
+        if(!serverConfigFound) {
+                cout << "No <serverConfig>-Tag in config file. Use default port 16664 and application name configuration." << endl;
+        }
+}
+
+void ua_uaadapter::readAdditionalNodes() {
+        for(const AdditionalNodesEntry &additional : this->additionalNodes) {
+                if(additional.folderName.empty()) {
+                        cout << "There is no folder name specified, ignore <additionalNode>-Element. Please set a name" << endl;
+                        continue;
+                }
+                UA_NodeId folderNodeId = this->createFolder(this->ownNodeId, additional.folderName, additional.description);
+                for(const AdditionalVariableEntry &variable : additional.variables) {
+                        this->additionalVariables.push_back(new ua_additionalvariable(this->mappedServer, folderNodeId, variable.name, variable.value, variable.description));
                 }
+        }
+        // Only needed until the nodes exist
+        vector<AdditionalNodesEntry>().swap(this->additionalNodes);
+}
+
+void ua_uaadapter::workerThread() {
+        if (this->mappedServer == nullptr) {
+                return;
+        }
+        this->runServerLoop();
+}
 
-                placeHolder = this->fileHandler->getAttributeValueFromNode(nodeset->nodeTab[0], "username");
-                if(!placeHolder.empty()) {
-                        this->serverConfig.username = placeHolder;
+void ua_uaadapter::runServerLoop() {
+        int epollFd = epoll_create1(EPOLL_CLOEXEC);
+        int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        bool registered = epollFd >= 0 && timerFd >= 0 && this->wakeupFd >= 0;
+        if(registered) {
+                event.data.fd = this->wakeupFd;
+                registered = epoll_ctl(epollFd, EPOLL_CTL_ADD, this->wakeupFd, &event) == 0;
+        }
+        if(registered) {
+                event.data.fd = timerFd;
+                registered = epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &event) == 0;
+        }
+        if(!registered) {
+                // Without the descriptors the stack polls with its own timeout
+                if(epollFd >= 0) close(epollFd);
+                if(timerFd >= 0) close(timerFd);
+                if(UA_Server_run(this->mappedServer, &this->thread_run) != UA_STATUSCODE_GOOD) {
+                        cout << "Error during establishing the network interface." << endl;
                 }
+                return;
         }
-        else {
-                        this->serverConfig.UsernamePasswordLogin = UA_FALSE;
+
+        if(UA_Server_run_startup(this->mappedServer) != UA_STATUSCODE_GOOD) {
+                cout << "Error during establishing the network interface." << endl;
+                close(epollFd);
+                close(timerFd);
+                return;
         }
 
-        result = this->fileHandler->getNodeSet(xpath +"//serverConfig");
-        if(result) {
-                xmlNodeSetPtr nodeset = result->nodesetval;
-                string opcuaPort = this->fileHandler->getAttributeValueFromNode(nodeset->nodeTab[0], "port");
-                if(opcuaPort.compare("") != 0) {
-                        this->serverConfig.opcuaPort = std::stoi(opcuaPort);
+        // Sockets registered with epollFd and the generation of their connection
+        std::unordered_map<UA_Int32, UA_UInt64> epollSockets;
+        vector<UA_Int32> sockets;
+        vector<UA_UInt64> generations;
+        bool timerFailed = false;
+        struct epoll_event events[UA_ADAPTER_LOOP_EVENTS];
+        while(this->thread_run) {
+                // Handle everything which is ready without waiting: due repeated jobs, new connections and received messages
+                UA_Server_run_iterate(this->mappedServer, false);
+
+                // Only register sockets which appeared since the last iteration. The network layer closes a socket before it
+                // drops it from its set, which already removes it from epollFd. An accepted connection may then reuse the
+                // number, so a socket is only unchanged if the generation of its connection is unchanged as well.
+                size_t socketCount = UA_ServerNetworkLayerTCP_getSockets(&this->server_nl, NULL, NULL, 0);
+                sockets.resize(socketCount);
+                generations.resize(socketCount);
+                UA_ServerNetworkLayerTCP_getSockets(&this->server_nl, sockets.data(), generations.data(), socketCount);
+                bool unregistered = false;
+                size_t watched = 0;
+                for(size_t i = 0; i < socketCount; i++) {
+                        auto known = epollSockets.find(sockets[i]);
+                        if(known != epollSockets.end() && known->second == generations[i]) {
+                                watched++;
+                                continue;
+                        }
+                        event.data.fd = sockets[i];
+                        if(epoll_ctl(epollFd, EPOLL_CTL_ADD, sockets[i], &event) != 0 && errno != EEXIST) {
+                                // Tried again in the next iteration, until then the loop polls
+                                cout << "Socket " << sockets[i] << " cannot be watched by the server loop: " << strerror(errno) << endl;
+                                if(known != epollSockets.end()) {
+                                        epollSockets.erase(known);
+                                }
+                                unregistered = true;
+                                continue;
+                        }
+                        epollSockets[sockets[i]] = generations[i];
+                        watched++;
                 }
-                else {
-                        cout << "No 'port'-Attribute in config file is set. Use default Port: 16664" << endl;
+                // Forget the sockets which were closed, the kernel removed them from epollFd with their last descriptor
+                if(epollSockets.size() > watched) {
+                        std::unordered_set<UA_Int32> current(sockets.begin(), sockets.end());
+                        for(auto known = epollSockets.begin(); known != epollSockets.end();) {
+                                if(current.count(known->first) == 0) {
+                                        known = epollSockets.erase(known);
+                                }
+                                else {
+                                        ++known;
+                                }
+                        }
                 }
 
-                placeHolder = this->fileHandler->getAttributeValueFromNode(nodeset->nodeTab[0], "applicationName");
-                if(placeHolder.compare("") != 0) {
-                        this->serverConfig.applicationName = placeHolder;
+                // Sleep until the next repeated job at the latest, a disarmed timer if there is none
+                UA_DateTime nextJob = UA_Server_getNextRepeatedJobTime(this->mappedServer);
+                UA_DateTime now = UA_DateTime_nowMonotonic();
+                if(nextJob <= now) {
+                        continue;
                 }
-                else {
-                        cout << "No 'applicationName'-Attribute is set in config file. Use default Applicationname." << endl;
+                int timeout = unregistered ? UA_ADAPTER_LOOP_POLL_MS : -1;
+                struct itimerspec timer;
+                memset(&timer, 0, sizeof(timer));
+                if(nextJob != UA_INT64_MAX) {
+                        UA_DateTime delay = nextJob - now;
+                        timer.it_value.tv_sec = delay / UA_SEC_TO_DATETIME;
+                        timer.it_value.tv_nsec = (delay % UA_SEC_TO_DATETIME) * 100;
+                }
+                if(timerfd_settime(timerFd, 0, &timer, NULL) != 0) {
+                        if(!timerFailed) {
+                                cout << "Timer of the server loop cannot be set, the loop polls instead: " << strerror(errno) << endl;
+                                timerFailed = true;
+                        }
+                        timeout = UA_ADAPTER_LOOP_POLL_MS;
+                }
+
+                int ready = epoll_wait(epollFd, events, UA_ADAPTER_LOOP_EVENTS, timeout);
+                bool woken = false;
+                for(int i = 0; i < ready; i++) {
+                        if(events[i].data.fd == this->wakeupFd || events[i].data.fd == timerFd) {
+                                uint64_t count;
+                                ssize_t readSize = read(events[i].data.fd, &count, sizeof(count));
+                                (void) readSize;
+                                woken = woken || events[i].data.fd == this->wakeupFd;
+                        }
+                }
+                // Values pushed by other threads reach the server before it handles its jobs
+                if(woken && this->wakeupListener) {
+                        this->wakeupListener();
                 }
         }
-        else {
-                cout << "No <serverConfig>-Tag in config file. Use default port 16664 and application name configuration." << endl;
+
+        UA_Server_run_shutdown(this->mappedServer);
+        close(timerFd);
+        close(epollFd);
+}
+
+void ua_uaadapter::stopRequested() {
+        this->wakeup();
+}
+
+void ua_uaadapter::wakeup() {
+        uint64_t one = 1;
+        if(this->wakeupFd >= 0) {
+                ssize_t written = write(this->wakeupFd, &one, sizeof(one));
+                (void) written;
         }
 }
 
-void ua_uaadapter::readAdditionalNodes() {
-        xmlXPathObjectPtr result = this->fileHandler->getNodeSet("//additionalNodes");
-        if(result) {
-                xmlNodeSetPtr nodeset = result->nodesetval;
-                for (int32_t i=0; i < nodeset->nodeNr; i++) {
+void ua_uaadapter::setWakeupListener(std::function<void()> listener) {
+        this->wakeupListener = listener;
+}
+
+VariablePlan ua_uaadapter::prepareVariable(const string &name) const {
+        VariablePlan plan;
+        plan.name = name;
 
-                        string folderName = this->fileHandler->getAttributeValueFromNode(nodeset->nodeTab[i], "folderName");
-                        string folderDescription = this->fileHandler->getAttributeValueFromNode(nodeset->nodeTab[i], "description");
-                        if(folderName.empty()) {
-                                cout << "There is no folder name specified, ignore <additionalNode>-Element. Please set a name" << endl;
+        // Position in mapEntries -> captures, exact entries have none. Both kinds are applied in the order of the mapping file
+        vector<pair<size_t, vector<string>>> matches;
+        unordered_map<string, vector<size_t>>::const_iterator mapped = this->mapIndex.find(name);
+        if(mapped != this->mapIndex.end()) {
+                for(size_t entryPos : mapped->second) {
+                        matches.push_back(make_pair(entryPos, vector<string>()));
+                }
+        }
+        if(this->mapMatcher.size() > 0) {
+                for(ua_map_matcher::Match &match : this->mapMatcher.match(name)) {
+                        matches.push_back(make_pair(this->patternEntries[match.rule], std::move(match.captures)));
+                }
+                sort(matches.begin(), matches.end(), [](const pair<size_t, vector<string>> &a, const pair<size_t, vector<string>> &b) { return a.first < b.first; });
+        }
+
+        for(const pair<size_t, vector<string>> &match : matches) {
+                const MapEntry &entry = this->mapEntries[match.first];
+                MappingPlan mapping;
+                mapping.entry = &entry;
+                // Check if "rename" is not empty
+                mapping.renameVar = entry.rename;
+                if(entry.pattern) {
+                        mapping.renameVar = ua_map_matcher::substitute(entry.rename, match.second);
+                        for(const string &folderTemplate : entry.folderTemplates) {
+                                mapping.folderPaths.push_back(xml_file_handler::praseVariablePath(ua_map_matcher::substitute(folderTemplate, match.second)));
+                        }
+                }
+
+                // Deadband for subscriptions which request none of their own, the absolute deadband takes precedence
+                if(!entry.deadbandAbsolute.empty() || !entry.deadbandRelative.empty()) {
+                        mapping.hasDeadband = true;
+                        mapping.deadbandType = entry.deadbandAbsolute.empty() ? UA_DEADBANDTYPE_PERCENT : UA_DEADBANDTYPE_ABSOLUTE;
+                        mapping.deadbandString = entry.deadbandAbsolute.empty() ? entry.deadbandRelative : entry.deadbandAbsolute;
+                        try {
+                                mapping.deadbandValue = std::stod(mapping.deadbandString);
+                                mapping.deadbandParsed = true;
+                        }
+                        catch(std::exception &e) {
+                        }
+                }
+
+                if(!entry.unrollPathSeparator.empty()) {
+                        mapping.varPathVector = xml_file_handler::praseVariablePath(name, entry.unrollPathSeparator);
+                }
+
+                // assumption last element is name of variable, hence no folder for name is needed
+                if(mapping.renameVar.compare("") == 0 && !entry.unrollPath) {
+                        mapping.renameVar = name;
+                }
+                else if(entry.unrollPath && mapping.renameVar.compare("") == 0) {
+                        mapping.renameVar = mapping.varPathVector.at(mapping.varPathVector.size()-1);
+                        mapping.varPathVector.pop_back();
+                }
+                else if(mapping.varPathVector.size() > 0) {
+                        mapping.varPathVector.pop_back();
+                }
+                plan.mappings.push_back(mapping);
+        }
+        return plan;
+}
+
+bool ua_uaadapter::isFiltered(const string &name) const {
+        if(this->includeFilter.size() > 0 && !this->includeFilter.matchesAny(name)) {
+                return true;
+        }
+        return this->excludeFilter.size() > 0 && this->excludeFilter.matchesAny(name);
+}
+
+size_t ua_uaadapter::getFilteredVariableCount() {
+        return this->filteredCount;
+}
+
+void ua_uaadapter::addVariable(std::string varName, boost::shared_ptr<ControlSystemPVManager> csManager) {
+        if(this->isFiltered(varName)) {
+                this->filteredCount++;
+                return;
+        }
+        if(this->serverConfig.lazyInstantiation) {
+                this->deferVariable(this->prepareVariable(varName), csManager);
+                return;
+        }
+        this->commitVariable(this->prepareVariable(varName), csManager);
+}
+
+void ua_uaadapter::addVariables(const vector<string> &allNames, boost::shared_ptr<ControlSystemPVManager> csManager) {
+        // Filtered variables are dropped before any plan is prepared
+        vector<string> selectedNames;
+        bool filtering = this->includeFilter.size() > 0 || this->excludeFilter.size() > 0;
+        if(filtering) {
+                for(const string &name : allNames) {
+                        if(this->isFiltered(name)) {
+                                this->filteredCount++;
                         }
                         else {
-                                UA_NodeId folderNodeId = this->createFolder(this->ownNodeId, folderName, folderDescription);
+                                selectedNames.push_back(name);
+                        }
+                }
+        }
+        const vector<string> &names = filtering ? selectedNames : allNames;
 
-                                vector<xmlNodePtr> variableNodeList = this->fileHandler->getNodesByName(nodeset->nodeTab[i]->children, "variable");
+        vector<VariablePlan> plans(names.size());
+        if(names.empty()) {
+                return;
+        }
 
-                                for(auto variableNode: variableNodeList) {
-                                        string name = this->fileHandler->getAttributeValueFromNode(variableNode, "name").c_str();
-                                        string value = this->fileHandler->getAttributeValueFromNode(variableNode, "value");
-                                        string description = this->fileHandler->getAttributeValueFromNode(variableNode, "description");
-                                        this->additionalVariables.push_back(new ua_additionalvariable(this->mappedServer, folderNodeId, name, value, description));
-                                }
+        // Resolve the plans in parallel, every worker fills its own stride of the plan vector
+        size_t workerCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), names.size());
+        vector<std::future<void>> workers;
+        for(size_t worker = 1; worker < workerCount; worker++) {
+                workers.push_back(std::async(std::launch::async, [this, &names, &plans, worker, workerCount]() {
+                        for(size_t i = worker; i < names.size(); i += workerCount) {
+                                plans[i] = this->prepareVariable(names[i]);
                         }
+                }));
+        }
+        for(size_t i = 0; i < names.size(); i += workerCount) {
+                plans[i] = this->prepareVariable(names[i]);
+        }
+        for(std::future<void> &w : workers) {
+                w.get();
+        }
+
+        // The server is not thread safe, so the nodes are created here in the given order
+        if(!this->serverConfig.lazyInstantiation && !this->serverConfig.snapshotFile.empty()) {
+                this->commitVariablesWithSnapshot(plans, csManager);
+                return;
+        }
+        for(const VariablePlan &plan : plans) {
+                if(this->serverConfig.lazyInstantiation) {
+                        this->deferVariable(plan, csManager);
+                }
+                else {
+                        this->commitVariable(plan, csManager);
                 }
         }
 }
 
-void ua_uaadapter::workerThread() {
-        if (this->mappedServer == nullptr) {
+void ua_uaadapter::deferVariable(const VariablePlan &plan, boost::shared_ptr<ControlSystemPVManager> csManager) {
+        size_t pos = this->deferredVariables.size();
+        DeferredVariable deferred;
+        deferred.plan = plan;
+        deferred.csManager = csManager;
+        this->deferredVariables.push_back(deferred);
+        this->deferredCount++;
+
+        // The processvariable object itself is listed in the variables folder
+        vector<UA_NodeId> parents(1, this->variablesListId);
+        for(const MappingPlan &mapping : plan.mappings) {
+                vector<UA_NodeId> mappedParents = this->createMappingFolders(mapping);
+                parents.insert(parents.end(), mappedParents.begin(), mappedParents.end());
+        }
+
+        for(const UA_NodeId &parent : parents) {
+                auto deferredChildren = this->deferredByParent.find(parent);
+                if(deferredChildren == this->deferredByParent.end()) {
+                        UA_NodeId parentKey;
+                        UA_NodeId_copy(&parent, &parentKey);
+                        deferredChildren = this->deferredByParent.emplace(parentKey, vector<size_t>()).first;
+                }
+                deferredChildren->second.push_back(pos);
+        }
+        this->deferredByName[plan.name] = pos;
+}
+
+void ua_uaadapter::commitDeferredVariable(size_t pos) {
+        DeferredVariable &deferred = this->deferredVariables[pos];
+        if(deferred.committed) {
                 return;
         }
+        deferred.committed = true;
+        this->deferredCount--;
 
-        UA_Boolean runUAServer = UA_TRUE;
+        this->commitVariable(deferred.plan, deferred.csManager);
+        if(this->variableListener) {
+                this->variableListener(this->variables.back());
+        }
+}
 
-// 		std::packaged_task<UA_StatusCode(UA_Server*, UA_Boolean*)> task(UA_Server_run);
-//    std::future<UA_StatusCode> result = task.get_future();
-//    std::thread *serverThread = new std::thread (std::move(task), this->mappedServer, &runUAServer);
+void ua_uaadapter::accessNode(const UA_NodeId &nodeId) {
+        // Committing browses and reads nodes itself
+        if(this->deferredCount == 0 || this->committingDeferred) {
+                return;
+        }
+        this->committingDeferred = true;
+
+        auto deferredChildren = this->deferredByParent.find(nodeId);
+        if(deferredChildren != this->deferredByParent.end()) {
+                UA_NodeId parentKey = deferredChildren->first;
+                vector<size_t> children;
+                children.swap(deferredChildren->second);
+                this->deferredByParent.erase(deferredChildren);
+                UA_NodeId_deleteMembers(&parentKey);
+                for(size_t pos : children) {
+                        this->commitDeferredVariable(pos);
+                }
+        }
+
+        if(nodeId.namespaceIndex == 1 && nodeId.identifierType == UA_NODEIDTYPE_STRING && nodeId.identifier.string.length > 0) {
+                string name((const char *) nodeId.identifier.string.data, nodeId.identifier.string.length);
+                unordered_map<string, size_t>::iterator deferred = this->deferredByName.find(name);
+                if(deferred != this->deferredByName.end()) {
+                        this->commitDeferredVariable(deferred->second);
+                }
+        }
+
+        this->committingDeferred = false;
+}
 
-                //std::future<UA_StatusCode> serverThread = std::async(std::launch::async, UA_Server_run, this->mappedServer, &runUAServer);
+size_t ua_uaadapter::getDeferredVariableCount() {
+        return this->deferredCount;
+}
 
+void ua_uaadapter::setVariableListener(std::function<void(ua_processvariable *)> listener) {
+        this->variableListener = listener;
+}
 
-        thread *serverThread = new std::thread(UA_Server_run, this->mappedServer, &runUAServer);
-//  		std::future<UA_StatusCode> serverThread = std::async(std::launch::async, UA_Server_run, this->mappedServer, &runUAServer);
-//  		if(serverThread.get() != UA_STATUSCODE_GOOD) {
-//  			cout << "Error during establishing the network interface." << endl;
-//  			exit(0);
-//   		}
+vector<UA_NodeId> ua_uaadapter::createMappingFolders(const MappingPlan &mapping) {
+        const MapEntry &entry = *mapping.entry;
+        const vector<string> &varPathVector = mapping.varPathVector;
+
+        // Application Name have to be unique!!!
+        UA_NodeId appliFolderNodeId = this->createFolder(this->ownNodeId, entry.applicationName);
+
+        bool createdVar = false;
+        UA_NodeId newFolderNodeId = UA_NODEID_NULL;
+        vector<UA_NodeId> mappedVariables;
+        for(const vector<string> &folderPathVector : entry.pattern ? mapping.folderPaths : entry.folderPaths) {
+                // Create folders
+                newFolderNodeId = appliFolderNodeId;
+                if(folderPathVector.size() > 0) {
+                        newFolderNodeId = this->createFolderPath(newFolderNodeId, folderPathVector);
+                }
 
-        while (runUAServer == true) {
-                 if (! this->isRunning()) {
-                         runUAServer = false;
+                if(varPathVector.size() > 0) {
+                        newFolderNodeId = this->createFolderPath(newFolderNodeId, varPathVector);
                 }
-                sleep(1);
+                mappedVariables.push_back(newFolderNodeId);
+                createdVar = true;
         }
 
-        if (serverThread->joinable()) {
-        serverThread->join();
-  }
+        // in case no <folder> or <unrollpath> is set
+        if(!createdVar) {
+                newFolderNodeId = appliFolderNodeId;
 
-        delete serverThread;
-        serverThread = NULL;
+                if(varPathVector.size() > 0) {
+                        mappedVariables.push_back(this->createFolderPath(newFolderNodeId, varPathVector));
+                }
+                else {
+                        // No <folder>
+                        mappedVariables.push_back(appliFolderNodeId);
+                }
+        }
+        return mappedVariables;
 }
 
-void ua_uaadapter::addVariable(std::string varName, boost::shared_ptr<ControlSystemPVManager> csManager) {
+void ua_uaadapter::commitVariable(const VariablePlan &plan, boost::shared_ptr<ControlSystemPVManager> csManager) {
+        ua_processvariable *processvariable = new ua_processvariable(this->mappedServer, this->variablesListId, plan.name, csManager);
+        this->registerVariable(processvariable);
+        this->commitMappings(plan, processvariable);
+}
 
-        ua_processvariable *processvariable = new ua_processvariable(this->mappedServer, this->variablesListId, varName, csManager);
+void ua_uaadapter::registerVariable(ua_processvariable *processvariable) {
+        processvariable->setZeroCopyArrays(this->serverConfig.zeroCopyArrays);
+        processvariable->setWriteBatch(&this->writeBatch);
         this->variables.push_back(processvariable);
+}
 
-        xmlXPathObjectPtr result = this->fileHandler->getNodeSet("//map");
-        xmlNodeSetPtr nodeset;
-        string srcVarName = "";
-        string applicName = "";
-
+void ua_uaadapter::commitMappings(const VariablePlan &plan, ua_processvariable *processvariable) {
         // TODO. What happen if application name are not unique?
-        if(result) {
-                nodeset = result->nodesetval;
-                for (int32_t i=0; i < nodeset->nodeNr; i++) {
-                        srcVarName = this->fileHandler->getAttributeValueFromNode(nodeset->nodeTab[i], "sourceVariableName");
-                        //keyword = xmlNodeListGetString(this->fileHandler->getDoc(), nodeset->nodeTab[i]->xmlChildrenNode, 1);
-                        if(varName.compare(srcVarName) == 0) {
-                                // get name attribute from <application>-tag
-                                applicName = this->fileHandler->getAttributeValueFromNode(nodeset->nodeTab[i]->parent, "name");
-                                // Check if "rename" is not empty
-                                string renameVar = this->fileHandler->getAttributeValueFromNode(nodeset->nodeTab[i], "rename");
-                                string engineeringUnit = this->fileHandler->getAttributeValueFromNode(nodeset->nodeTab[i], "engineeringUnit");
-                                string description = this->fileHandler->getAttributeValueFromNode(nodeset->nodeTab[i], "description");
-
-                                // Application Name have to be unique!!!
-                                UA_NodeId appliFolderNodeId = this->existFolder(this->ownNodeId, applicName);
-                                FolderInfo newFolder;
-                                if(UA_NodeId_isNull(&appliFolderNodeId)) {
-                                        newFolder.folderName = applicName;
-                                        newFolder.folderNodeId = this->createFolder(this->ownNodeId, applicName);
-                                        this->folderVector.push_back(newFolder);
-                                        appliFolderNodeId = newFolder.folderNodeId;
-                                }
+        for(const MappingPlan &mapping : plan.mappings) {
+                const MapEntry &entry = *mapping.entry;
+                const string &srcVarName = plan.name;
+                const string &applicName = entry.applicationName;
+                const string &renameVar = mapping.renameVar;
+                const string &engineeringUnit = entry.engineeringUnit;
+                const string &description = entry.description;
+
+                if(mapping.hasDeadband) {
+                        UA_StatusCode retval = UA_STATUSCODE_BADDEADBANDFILTERINVALID;
+                        if(mapping.deadbandParsed) {
+                                retval = processvariable->setDeadband(mapping.deadbandType, mapping.deadbandValue);
+                        }
+                        if(retval != UA_STATUSCODE_GOOD) {
+                                cout << "Deadband '" << mapping.deadbandString << "' of variable '" << srcVarName << "' is invalid and ignored." << endl;
+                        }
+                }
 
-                                vector<string> varPathVector;
-                                vector<xmlNodePtr> nodeVectorUnrollPath = this->fileHandler->getNodesByName(nodeset->nodeTab[i]->children, "unrollPath");
-                                string seperator = "";
-                                bool unrollPathIs = false;
-                                for(auto nodeUnrollPath: nodeVectorUnrollPath) {
-                                        string shouldUnrollPath = this->fileHandler->getContentFromNode(nodeUnrollPath);
-                                        if(shouldUnrollPath.compare("True") == 0) {
-                                                seperator = seperator + this->fileHandler->getAttributeValueFromNode(nodeUnrollPath, "pathSep");
-                                                unrollPathIs = true;
-                                        }
+                if(entry.rename.compare("") == 0 && !entry.unrollPath) {
+                        std::cout << "Variable '" << srcVarName << "' renamed in '" << renameVar << "' and listed in folder '" << applicName << "'." << std::endl;
+                }
+                else {
+                        std::cout << "Variable '" << srcVarName << "' listed in folder '" << applicName << "'." << std::endl;
+                }
+
+                vector<UA_NodeId> mappedVariables = this->createMappingFolders(mapping);
+
+                // Create all nessesary mapped ObjectVaraibles with inner variables (reference or attribute, depending attributes are set (engineeringUnit, dexcription)
+                for(auto objectNodeId:mappedVariables) {
+                        UA_NodeId createdNodeId = UA_NODEID_NULL;
+
+                        // Create our new "Value" Variable
+                        UA_ObjectAttributes oAttr;
+                        UA_ObjectAttributes_init(&oAttr);
+                        oAttr.displayName = UA_LOCALIZEDTEXT_ALLOC("en_US", renameVar.c_str());
+                        oAttr.description = UA_LOCALIZEDTEXT_ALLOC("en_US", description.c_str());
+
+                        UA_INSTATIATIONCALLBACK(icb);
+                        UA_Server_addObjectNode(this->mappedServer, UA_NODEID_NUMERIC(1, 0),
+                                                                                        objectNodeId, UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                                                                        UA_QUALIFIEDNAME_ALLOC(1, renameVar.c_str()), UA_NODEID_NULL, oAttr, &icb, &createdNodeId);
+                        if(this->recordSnapshotNodes) {
+                                this->snapshotNodes.push_back(createdNodeId);
+                        }
+
+                        UA_ExpandedNodeId *targetNodeId = UA_ExpandedNodeId_new();
+                        targetNodeId->nodeId = createdNodeId;
+
+                        UA_BrowseDescription bDesc;
+                        UA_BrowseDescription_init(&bDesc);
+                        bDesc.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+                        bDesc.includeSubtypes = false;
+                        bDesc.nodeClassMask = UA_NODECLASS_VARIABLE;
+                        bDesc.nodeId = processvariable->getOwnNodeId();
+                        bDesc.resultMask = UA_BROWSERESULTMASK_ALL;
+
+                        UA_BrowseResult bRes;
+                        UA_BrowseResult_init(&bRes);
+
+                        UA_VariableAttributes vAttr;
+                        UA_VariableAttributes_init(&vAttr);
+                        vAttr.dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_STRING);
+                        vAttr.accessLevel = UA_ACCESSLEVELMASK_WRITE^UA_ACCESSLEVELMASK_READ;
+                        vAttr.userAccessLevel = UA_ACCESSLEVELMASK_WRITE^UA_ACCESSLEVELMASK_READ;
+                        vAttr.valueRank = -1;
+
+
+                        bRes = UA_Server_browse(this->mappedServer, 10, &bDesc);
+
+                        for(uint32_t i=0; i < bRes.referencesSize; i++) {
+                                UA_NodeId newNodeId = UA_NODEID_NULL;
+
+                                UA_String varName = UA_String_fromChars("EngineeringUnit");
+                                if(UA_String_equal(&bRes.references[i].browseName.name, &varName) && !engineeringUnit.empty()) {
+                                        vAttr.description = UA_LOCALIZEDTEXT((char*)"en_US",(char*) "EngineeringUnit");
+                                        vAttr.displayName = UA_LOCALIZEDTEXT((char*)"en_US",(char*) "EngineeringUnit");
+
+                                        UA_String engineringUnit = UA_String_fromChars(engineeringUnit.c_str());
+                                        UA_Variant_setScalar(&vAttr.value, &engineringUnit, &UA_TYPES[UA_TYPES_STRING]);
+                                        UA_Server_addVariableNode(this->mappedServer, UA_NODEID_NUMERIC(1, 0), createdNodeId,
+                                                                                                                        UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), UA_QUALIFIEDNAME(1, (char*) "EngineeringUnit"),
+                                                                                                                        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), vAttr, &icb, &newNodeId);
                                 }
 
-                                if(!seperator.empty()) {
-                                        vector<string> newPathVector = this->fileHandler->praseVariablePath(srcVarName, seperator);
-                                        varPathVector.insert(varPathVector.end(), newPathVector.begin(), newPathVector.end());
+                                varName = UA_String_fromChars("Description");
+                                if(UA_String_equal(&bRes.references[i].browseName.name, &varName) && !description.empty()) {
+                                        vAttr.description = UA_LOCALIZEDTEXT((char*)"en_US",(char*) "Description");
+                                        vAttr.displayName = UA_LOCALIZEDTEXT((char*)"en_US",(char*) "Description");
+
+                                        UA_String engineringUnit = UA_String_fromChars(description.c_str());
+                                        UA_Variant_setScalar(&vAttr.value, &engineringUnit, &UA_TYPES[UA_TYPES_STRING]);
+                                        UA_Server_addVariableNode(this->mappedServer, UA_NODEID_NUMERIC(1, 0), createdNodeId,
+                                                                                                                        UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), UA_QUALIFIEDNAME(1, (char*) "Description"),
+                                                                                                                        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), vAttr, &icb, &newNodeId);
                                 }
 
-                                // assumption last element is name of variable, hence no folder for name is needed
-                                if(renameVar.compare("") == 0 && !unrollPathIs) {
-                                        renameVar = srcVarName;
-                                        std::cout << "Variable '" << srcVarName << "' renamed in '" << renameVar << "' and listed in folder '" << applicName << "'." << std::endl;
+                                if(!UA_NodeId_isNull(&newNodeId) && this->recordSnapshotNodes) {
+                                        this->snapshotNodes.push_back(newNodeId);
                                 }
-                                else {
-                                        if(unrollPathIs && renameVar.compare("") == 0) {
-                                                renameVar = varPathVector.at(varPathVector.size()-1);
-                                                varPathVector.pop_back();
-                                        }
-                                        else {
-                                                if(varPathVector.size() > 0) {
-                                                        varPathVector.pop_back();
-                                                }
-                                        }
-                                        std::cout << "Variable '" << srcVarName << "' listed in folder '" << applicName << "'." << std::endl;
+                                if(UA_NodeId_isNull(&newNodeId)) {
+                                        UA_Server_addReference(this->mappedServer, bRes.references[i].nodeId.nodeId, UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), *targetNodeId, false);
                                 }
+                        }
 
+                        UA_BrowseDescription_deleteMembers(&bDesc);
+                        UA_BrowseResult_deleteMembers(&bRes);
 
+                }
+        }
+}
 
-                                vector<xmlNodePtr> nodeVectorFolderPath = this->fileHandler->getNodesByName(nodeset->nodeTab[i]->children, "folder");
-                                vector<string> folderPathVector;
-                                bool createdVar = false;
-                                UA_NodeId newFolderNodeId = UA_NODEID_NULL;
-                                vector<UA_NodeId> mappedVariables;
-                                for(auto nodeFolderPath: nodeVectorFolderPath) {
+void ua_uaadapter::commitVariablesWithSnapshot(const vector<VariablePlan> &plans, boost::shared_ptr<ControlSystemPVManager> csManager) {
+        // Resolving does not touch the server, the nodes are then restored or built
+        vector<ua_processvariable *> resolved;
+        for(const VariablePlan &plan : plans) {
+                resolved.push_back(new ua_processvariable(this->mappedServer, this->variablesListId, plan.name, csManager, false));
+        }
 
-                                                string folderPath = this->fileHandler->getContentFromNode(nodeFolderPath);
-                                                if(folderPath.empty() && unrollPathIs) {
-                                                        break;
-                                                }
+        uint64_t inputHash = this->hashSnapshotInputs(resolved);
+        if(this->loadSnapshot(inputHash, resolved)) {
+                for(ua_processvariable *processvariable : resolved) {
+                        this->registerVariable(processvariable);
+                }
+                this->restoredFromSnapshot = true;
+                return;
+        }
 
-                                                folderPathVector = this->fileHandler->praseVariablePath(folderPath);
-                                                // Create folders
-                                                newFolderNodeId = appliFolderNodeId;
-                                                if(folderPathVector.size() > 0) {
-                                                        newFolderNodeId = this->createFolderPath(newFolderNodeId, folderPathVector);
-                                                }
+        size_t firstFolder = this->folderVector.size();
+        this->snapshotNodes.clear();
+        this->recordSnapshotNodes = true;
+        for(size_t i = 0; i < plans.size(); i++) {
+                resolved[i]->mapSelfToNamespace();
+                this->registerVariable(resolved[i]);
+                this->commitMappings(plans[i], resolved[i]);
+        }
+        this->recordSnapshotNodes = false;
+        this->saveSnapshot(inputHash, firstFolder, resolved);
+        this->snapshotNodes.clear();
+}
 
-                                                if(varPathVector.size() > 0) {
-                                                        newFolderNodeId = this->createFolderPath(newFolderNodeId, varPathVector);
-                                                }
-                                                mappedVariables.push_back(newFolderNodeId);
-                                                createdVar = true;
-                                }
+static void ua_uaadapter_hash(uint64_t &hash, const void *data, size_t length) {
+        // FNV-1a
+        const unsigned char *bytes = (const unsigned char *) data;
+        for(size_t i = 0; i < length; i++) {
+                hash ^= bytes[i];
+                hash *= 1099511628211ULL;
+        }
+}
+
+static void ua_uaadapter_hash(uint64_t &hash, const string &value) {
+        uint64_t length = value.size();
+        ua_uaadapter_hash(hash, &length, sizeof(length));
+        ua_uaadapter_hash(hash, value.data(), value.size());
+}
 
-                                // in case no <folder> or <unrollpath> is set
-                                if(!createdVar) {
-                                        newFolderNodeId = appliFolderNodeId;
+uint64_t ua_uaadapter::hashSnapshotInputs(const vector<ua_processvariable *> &resolved) {
+        uint64_t hash = 14695981039346656037ULL;
+        uint32_t version = UA_ADAPTER_SNAPSHOT_VERSION;
+        ua_uaadapter_hash(hash, &version, sizeof(version));
+
+        std::ifstream configFile(this->configPath.c_str(), std::ios::binary);
+        std::stringstream configContent;
+        configContent << configFile.rdbuf();
+        ua_uaadapter_hash(hash, configContent.str());
+
+        for(ua_processvariable *processvariable : resolved) {
+                uint64_t arrayLength = processvariable->getArrayLength();
+                unsigned char access = (processvariable->getProcessVariable()->isReadable() ? 1 : 0) | (processvariable->getProcessVariable()->isWriteable() ? 2 : 0);
+                ua_uaadapter_hash(hash, processvariable->getName());
+                ua_uaadapter_hash(hash, processvariable->getType());
+                ua_uaadapter_hash(hash, &arrayLength, sizeof(arrayLength));
+                ua_uaadapter_hash(hash, &access, sizeof(access));
+                ua_uaadapter_hash(hash, processvariable->getEngineeringUnit());
+                ua_uaadapter_hash(hash, processvariable->getDescription());
+        }
+        return hash;
+}
 
-                                        if(varPathVector.size() > 0) {
-                                                mappedVariables.push_back(this->createFolderPath(newFolderNodeId, varPathVector));
-                                        }
-                                        else {
-                                                // No <folder>
-                                                mappedVariables.push_back(appliFolderNodeId);
-                                        }
-                                }
+/* Sequential reader over the mapped snapshot file, every read fails once the end of the file is passed */
+class ua_snapshot_reader {
+public:
+        const char *pos;
+        const char *end;
+        bool failed;
 
-                                // Create all nessesary mapped ObjectVaraibles with inner variables (reference or attribute, depending attributes are set (engineeringUnit, dexcription)
-                                for(auto objectNodeId:mappedVariables) {
-                                        UA_NodeId createdNodeId = UA_NODEID_NULL;
-
-                                        // Create our new "Value" Variable
-                                        UA_ObjectAttributes oAttr;
-                                        UA_ObjectAttributes_init(&oAttr);
-                                        oAttr.displayName = UA_LOCALIZEDTEXT_ALLOC("en_US", renameVar.c_str());
-                                        oAttr.description = UA_LOCALIZEDTEXT_ALLOC("en_US", description.c_str());
-
-                                        UA_INSTATIATIONCALLBACK(icb);
-                                        UA_Server_addObjectNode(this->mappedServer, UA_NODEID_NUMERIC(1, 0),
-                                                                                                        objectNodeId, UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
-                                                                                                        UA_QUALIFIEDNAME_ALLOC(1, renameVar.c_str()), UA_NODEID_NULL, oAttr, &icb, &createdNodeId);
-
-                                        UA_ExpandedNodeId *targetNodeId = UA_ExpandedNodeId_new();
-                                        targetNodeId->nodeId = createdNodeId;
-
-                                        UA_BrowseDescription bDesc;
-                                        UA_BrowseDescription_init(&bDesc);
-                                        bDesc.browseDirection = UA_BROWSEDIRECTION_FORWARD;
-                                        bDesc.includeSubtypes = false;
-                                        bDesc.nodeClassMask = UA_NODECLASS_VARIABLE;
-                                        bDesc.nodeId = processvariable->getOwnNodeId();
-                                        bDesc.resultMask = UA_BROWSERESULTMASK_ALL;
-
-                                        UA_BrowseResult bRes;
-                                        UA_BrowseResult_init(&bRes);
-
-                                        UA_VariableAttributes vAttr;
-                                        UA_VariableAttributes_init(&vAttr);
-                                        vAttr.dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_STRING);
-                                        vAttr.accessLevel = UA_ACCESSLEVELMASK_WRITE^UA_ACCESSLEVELMASK_READ;
-                                        vAttr.userAccessLevel = UA_ACCESSLEVELMASK_WRITE^UA_ACCESSLEVELMASK_READ;
-                                        vAttr.valueRank = -1;
-
-
-                                        bRes = UA_Server_browse(this->mappedServer, 10, &bDesc);
-
-                                        for(uint32_t i=0; i < bRes.referencesSize; i++) {
-                                                UA_NodeId newNodeId = UA_NODEID_NULL;
-
-                                                UA_String varName = UA_String_fromChars("EngineeringUnit");
-                                                if(UA_String_equal(&bRes.references[i].browseName.name, &varName) && !engineeringUnit.empty()) {
-                                                        vAttr.description = UA_LOCALIZEDTEXT((char*)"en_US",(char*) "EngineeringUnit");
-                                                        vAttr.displayName = UA_LOCALIZEDTEXT((char*)"en_US",(char*) "EngineeringUnit");
-
-                                                        UA_String engineringUnit = UA_String_fromChars(engineeringUnit.c_str());
-                                                        UA_Variant_setScalar(&vAttr.value, &engineringUnit, &UA_TYPES[UA_TYPES_STRING]);
-                                                        UA_Server_addVariableNode(this->mappedServer, UA_NODEID_NUMERIC(1, 0), createdNodeId,
-                                                                                                                                        UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), UA_QUALIFIEDNAME(1, (char*) "EngineeringUnit"),
-                                                                                                                                        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), vAttr, &icb, &newNodeId);
-                                                }
-
-                                                varName = UA_String_fromChars("Description");
-                                                if(UA_String_equal(&bRes.references[i].browseName.name, &varName) && !description.empty()) {
-                                                        vAttr.description = UA_LOCALIZEDTEXT((char*)"en_US",(char*) "Description");
-                                                        vAttr.displayName = UA_LOCALIZEDTEXT((char*)"en_US",(char*) "Description");
-
-                                                        UA_String engineringUnit = UA_String_fromChars(description.c_str());
-                                                        UA_Variant_setScalar(&vAttr.value, &engineringUnit, &UA_TYPES[UA_TYPES_STRING]);
-                                                        UA_Server_addVariableNode(this->mappedServer, UA_NODEID_NUMERIC(1, 0), createdNodeId,
-                                                                                                                                        UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), UA_QUALIFIEDNAME(1, (char*) "Description"),
-                                                                                                                                        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), vAttr, &icb, &newNodeId);
-                                                }
-
-                                                if(UA_NodeId_isNull(&newNodeId)) {
-                                                        UA_Server_addReference(this->mappedServer, bRes.references[i].nodeId.nodeId, UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), *targetNodeId, false);
-                                                }
-                                        }
+        ua_snapshot_reader(const char *data, size_t length) : pos(data), end(data + length), failed(false) {}
+
+        template<typename T> T read() {
+                T value = T();
+                if(this->failed || (size_t)(this->end - this->pos) < sizeof(T)) {
+                        this->failed = true;
+                        return value;
+                }
+                memcpy(&value, this->pos, sizeof(T));
+                this->pos += sizeof(T);
+                return value;
+        }
 
-                                        UA_BrowseDescription_deleteMembers(&bDesc);
-                                        UA_BrowseResult_deleteMembers(&bRes);
+        UA_NodeId readNodeId() {
+                UA_UInt16 namespaceIndex = this->read<UA_UInt16>();
+                UA_UInt32 identifier = this->read<UA_UInt32>();
+                return UA_NODEID_NUMERIC(namespaceIndex, identifier);
+        }
+
+        string readString() {
+                uint32_t length = this->read<uint32_t>();
+                if(this->failed || (size_t)(this->end - this->pos) < length) {
+                        this->failed = true;
+                        return "";
+                }
+                string value(this->pos, length);
+                this->pos += length;
+                return value;
+        }
+};
+
+template<typename T>
+static void ua_snapshot_write(std::ofstream &file, const T &value) {
+        file.write((const char *) &value, sizeof(T));
+}
+
+static void ua_snapshot_writeNodeId(std::ofstream &file, const UA_NodeId &nodeId) {
+        ua_snapshot_write(file, nodeId.namespaceIndex);
+        ua_snapshot_write(file, nodeId.identifier.numeric);
+}
 
+bool ua_uaadapter::loadSnapshot(uint64_t inputHash, const vector<ua_processvariable *> &resolved) {
+        int fd = open(this->serverConfig.snapshotFile.c_str(), O_RDONLY);
+        if(fd < 0) {
+                return false;
+        }
+        struct stat fileStat;
+        if(fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+                close(fd);
+                return false;
+        }
+        size_t fileSize = (size_t) fileStat.st_size;
+        void *data = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if(data == MAP_FAILED) {
+                return false;
+        }
+
+        ua_snapshot_reader reader((const char *) data, fileSize);
+        bool loaded = false;
+        do {
+                if(reader.read<uint32_t>() != UA_ADAPTER_SNAPSHOT_MAGIC || reader.read<uint32_t>() != UA_ADAPTER_SNAPSHOT_VERSION || reader.read<uint64_t>() != inputHash) {
+                        cout << "Snapshot '" << this->serverConfig.snapshotFile << "' does not match the mapping and process variables, build all variables." << endl;
+                        break;
+                }
+
+                // The adapter folders are built at every start, references to them are moved to their current node ids
+                UA_NodeId remapFrom[2];
+                remapFrom[0] = reader.readNodeId();
+                remapFrom[1] = reader.readNodeId();
+                UA_NodeId remapTo[2] = {this->ownNodeId, this->variablesListId};
+
+                vector<FolderInfo> folders;
+                uint32_t folderCount = reader.read<uint32_t>();
+                for(uint32_t i = 0; i < folderCount && !reader.failed; i++) {
+                        folders.push_back(FolderInfo());
+                        FolderInfo &folder = folders.back();
+                        folder.prevFolderNodeId = reader.readNodeId();
+                        folder.folderNodeId = reader.readNodeId();
+                        folder.folderName = reader.readString();
+                        for(size_t i = 0; i < 2; i++) {
+                                if(UA_NodeId_equal(&folder.prevFolderNodeId, &remapFrom[i])) {
+                                        folder.prevFolderNodeId = remapTo[i];
                                 }
                         }
                 }
+
+                if(reader.read<uint32_t>() != resolved.size()) {
+                        break;
+                }
+                vector<UA_NodeId> objectNodeIds;
+                for(size_t i = 0; i < resolved.size(); i++) {
+                        objectNodeIds.push_back(reader.readNodeId());
+                }
+
+                UA_ByteString nodes;
+                nodes.length = reader.read<uint64_t>();
+                if(reader.failed || (size_t)(reader.end - reader.pos) != nodes.length) {
+                        break;
+                }
+                // The nodes are decoded straight from the mapped file
+                nodes.data = (UA_Byte *) reader.pos;
+                if(UA_Server_decodeNodes(this->mappedServer, &nodes, remapFrom, remapTo, 2) != UA_STATUSCODE_GOOD) {
+                        break;
+                }
+
+                for(const FolderInfo &folder : folders) {
+                        auto parent = this->folderIndex.find(folder.prevFolderNodeId);
+                        if(parent == this->folderIndex.end()) {
+                                UA_NodeId parentKey;
+                                UA_NodeId_copy(&folder.prevFolderNodeId, &parentKey);
+                                parent = this->folderIndex.emplace(parentKey, unordered_map<string, size_t>()).first;
+                        }
+                        parent->second.emplace(folder.folderName, this->folderVector.size());
+                        this->folderVector.push_back(folder);
+                }
+                for(size_t i = 0; i < resolved.size(); i++) {
+                        if(resolved[i]->bindToNamespace(objectNodeIds[i]) != UA_STATUSCODE_GOOD) {
+                                cout << "Variable '" << resolved[i]->getName() << "' is incomplete in snapshot '" << this->serverConfig.snapshotFile << "'." << endl;
+                        }
+                }
+                loaded = !reader.failed;
+        } while(false);
+
+        munmap(data, fileSize);
+        return loaded;
+}
+
+void ua_uaadapter::saveSnapshot(uint64_t inputHash, size_t firstFolder, const vector<ua_processvariable *> &resolved) {
+        vector<UA_NodeId> nodeIds(this->snapshotNodes);
+        for(size_t i = firstFolder; i < this->folderVector.size(); i++) {
+                nodeIds.push_back(this->folderVector[i].folderNodeId);
+        }
+        vector<UA_NodeId> objectNodeIds;
+        for(ua_processvariable *processvariable : resolved) {
+                vector<UA_NodeId> ownedNodeIds = processvariable->getOwnedNodeIds();
+                nodeIds.insert(nodeIds.end(), ownedNodeIds.begin(), ownedNodeIds.end());
+                objectNodeIds.push_back(processvariable->getOwnNodeId());
+        }
+
+        // Folders, objects and the adapter folders are stored by their numeric node id
+        vector<UA_NodeId> numericNodeIds(objectNodeIds);
+        numericNodeIds.push_back(this->ownNodeId);
+        numericNodeIds.push_back(this->variablesListId);
+        for(size_t i = firstFolder; i < this->folderVector.size(); i++) {
+                numericNodeIds.push_back(this->folderVector[i].folderNodeId);
+                numericNodeIds.push_back(this->folderVector[i].prevFolderNodeId);
+        }
+        for(const UA_NodeId &nodeId : numericNodeIds) {
+                if(nodeId.identifierType != UA_NODEIDTYPE_NUMERIC) {
+                        return;
+                }
+        }
+
+        UA_ByteString nodes;
+        if(UA_Server_encodeNodes(this->mappedServer, nodeIds.data(), nodeIds.size(), &nodes) != UA_STATUSCODE_GOOD) {
+                cout << "Snapshot of the address space could not be encoded." << endl;
+                return;
+        }
+
+        // Written next to the old snapshot and renamed, so a crash never leaves a partial snapshot behind
+        string tempFile = this->serverConfig.snapshotFile + ".tmp";
+        std::ofstream file(tempFile.c_str(), std::ios::binary | std::ios::trunc);
+        ua_snapshot_write(file, (uint32_t) UA_ADAPTER_SNAPSHOT_MAGIC);
+        ua_snapshot_write(file, (uint32_t) UA_ADAPTER_SNAPSHOT_VERSION);
+        ua_snapshot_write(file, inputHash);
+        ua_snapshot_writeNodeId(file, this->ownNodeId);
+        ua_snapshot_writeNodeId(file, this->variablesListId);
+        ua_snapshot_write(file, (uint32_t) (this->folderVector.size() - firstFolder));
+        for(size_t i = firstFolder; i < this->folderVector.size(); i++) {
+                ua_snapshot_writeNodeId(file, this->folderVector[i].prevFolderNodeId);
+                ua_snapshot_writeNodeId(file, this->folderVector[i].folderNodeId);
+                ua_snapshot_write(file, (uint32_t) this->folderVector[i].folderName.size());
+                file.write(this->folderVector[i].folderName.data(), this->folderVector[i].folderName.size());
+        }
+        ua_snapshot_write(file, (uint32_t) objectNodeIds.size());
+        for(const UA_NodeId &objectNodeId : objectNodeIds) {
+                ua_snapshot_writeNodeId(file, objectNodeId);
         }
+        ua_snapshot_write(file, (uint64_t) nodes.length);
+        file.write((const char *) nodes.data, nodes.length);
+        file.close();
+        UA_ByteString_deleteMembers(&nodes);
+
+        if(!file || rename(tempFile.c_str(), this->serverConfig.snapshotFile.c_str()) != 0) {
+                cout << "Snapshot '" << this->serverConfig.snapshotFile << "' could not be written." << endl;
+                remove(tempFile.c_str());
+        }
+}
 
-        xmlXPathFreeObject (result);
+bool ua_uaadapter::isRestoredFromSnapshot() {
+        return this->restoredFromSnapshot;
+}
+
+bool ua_uaadapter::isUpdatePumpEnabled() {
+        return this->serverConfig.updatePump;
 }
 
 vector<ua_processvariable *> ua_uaadapter::getVariables() {
         return this->variables;
 }
 
+UA_Server* ua_uaadapter::getMappedServer() {
+        return this->mappedServer;
+}
+
 UA_NodeId ua_uaadapter::createUAFolder(UA_NodeId basenodeid, std::string folderName, std::string description) {
         // FIXME: Check if folder name a possible name or should it be escaped (?!"§%-:, etc)
         UA_StatusCode retval = UA_STATUSCODE_GOOD;
@@ -494,13 +1296,15 @@ UA_NodeId ua_uaadapter::existFolderPath(UA_NodeId basenodeid, std::vector<string
 }
 
 UA_NodeId ua_uaadapter::existFolder(UA_NodeId basenodeid, string folder) {
-        UA_NodeId lastNodeId = UA_NODEID_NULL;
-        for(uint32_t i=0; i < this->folderVector.size(); i++) {
-                if((this->folderVector.at(i).folderName.compare(folder) == 0) && (UA_NodeId_equal(&this->folderVector.at(i).prevFolderNodeId, &basenodeid))) {
-                        return this->folderVector.at(i).folderNodeId;
-                }
+        auto parent = this->folderIndex.find(basenodeid);
+        if(parent == this->folderIndex.end()) {
+                return UA_NODEID_NULL;
+        }
+        auto child = parent->second.find(folder);
+        if(child == parent->second.end()) {
+                return UA_NODEID_NULL;
         }
-        return UA_NODEID_NULL;
+        return this->folderVector.at(child->second).folderNodeId;
 }
 
 UA_NodeId ua_uaadapter::createFolderPath(UA_NodeId basenodeid, std::vector<string> folderPath) {
@@ -509,40 +1313,14 @@ UA_NodeId ua_uaadapter::createFolderPath(UA_NodeId basenodeid, std::vector<strin
                 return UA_NODEID_NULL;
         }
 
-        // Check if path exist
-        UA_NodeId toCheckNodeId = existFolderPath(basenodeid, folderPath);
-        int32_t starter4Folder = 0;
-        UA_NodeId nextNodeId = basenodeid;
-        UA_NodeId startNodeId = basenodeid;
-        if(UA_NodeId_isNull(&toCheckNodeId)) {
-                bool setted = false;
-                // Check if path exist partly
-                for(uint32_t m=0; m < folderPath.size(); m++) {
-                        for(uint32_t i=0; i < this->folderVector.size(); i++) {
-                                // get correct folder NodeId from first folderPath element
-                                if(!setted && (folderPath.at(m).compare(this->folderVector.at(i).folderName) == 0) && (UA_NodeId_equal(&this->folderVector.at(i).prevFolderNodeId, &nextNodeId)) && ((m+1) < folderPath.size())) {
-                                        // remember on witch position the folder still exist
-                                        setted = true;
-                                        starter4Folder = m+1;
-                                        nextNodeId = this->folderVector.at(i).folderNodeId;
-                                }
-                                if(setted) {
-                                        break;
-                                }
-                        }
-                        setted = false;
+        // Follow the existing part of the path and create the rest, createFolder reuses existing folders
+        UA_NodeId prevNodeId = basenodeid;
+        for(const string &folderName : folderPath) {
+                prevNodeId = this->createFolder(prevNodeId, folderName);
+                if(UA_NodeId_isNull(&prevNodeId)) {
+                        break;
                 }
         }
-        else {
-                // Path exist nothing to do
-                return toCheckNodeId;
-        }
-
-        UA_NodeId prevNodeId = nextNodeId;
-        // use the remembered position to start the loop
-        for(uint32_t m=starter4Folder; m < folderPath.size(); m++) {
-                prevNodeId = this->createFolder(prevNodeId, folderPath.at(m));
-        }
         // return last created folder UA_NodeId
         return prevNodeId;
 }
@@ -553,40 +1331,56 @@ UA_NodeId ua_uaadapter::createFolder(UA_NodeId basenodeid, string folderName, st
                 return UA_NODEID_NULL;
         }
 
-        // Check if path exist
-        UA_NodeId toCheckNodeId = existFolder(basenodeid, folderName);
-        FolderInfo newFolder;
-        if(UA_NodeId_isNull(&toCheckNodeId)) {
-                newFolder.folderName = folderName;
-                newFolder.folderNodeId = this->createUAFolder(basenodeid, folderName, description);
-                newFolder.prevFolderNodeId = basenodeid;
-                this->folderVector.push_back(newFolder);
+        auto parent = this->folderIndex.find(basenodeid);
+        if(parent == this->folderIndex.end()) {
+                UA_NodeId parentKey;
+                UA_NodeId_copy(&basenodeid, &parentKey);
+                parent = this->folderIndex.emplace(parentKey, unordered_map<string, size_t>()).first;
+        }
+
+        // Check if folder exist
+        auto child = parent->second.find(folderName);
+        if(child != parent->second.end()) {
+                return this->folderVector.at(child->second).folderNodeId;
         }
 
+        FolderInfo newFolder;
+        newFolder.folderName = folderName;
+        newFolder.folderNodeId = this->createUAFolder(basenodeid, folderName, description);
+        newFolder.prevFolderNodeId = basenodeid;
+        parent->second.emplace(folderName, this->folderVector.size());
+        this->folderVector.push_back(newFolder);
+
         return newFolder.folderNodeId;
 }
 
 vector<string> ua_uaadapter::getAllNotMappableVariablesNames() {
 
         vector<string> notMappableVariablesNames;
-        xmlXPathObjectPtr result = this->fileHandler->getNodeSet("//map");
-
-        if(result) {
-                xmlNodeSetPtr nodeset = result->nodesetval;
-                for (int32_t i=0; i < nodeset->nodeNr; i++) {
-                        //for(auto var:this->variables) {
-                        bool mapped = false;
-                        string mappedVar = this->fileHandler->getAttributeValueFromNode(nodeset->nodeTab[i], "sourceVariableName");
-                        for(auto var:this->getVariables()) {
-                                if(var->getName().compare(mappedVar) == 0) {
-                                        mapped = true;
-                                }
-                        }
-                        if(!mapped) {
-                                notMappableVariablesNames.push_back(mappedVar);
+        unordered_set<string> variableNames;
+        for(auto var:this->getVariables()) {
+                variableNames.insert(var->getName());
+        }
+        for(const DeferredVariable &deferred : this->deferredVariables) {
+                variableNames.insert(deferred.plan.name);
+        }
+
+        // A pattern rule is not mappable if it matches none of the variables
+        vector<bool> ruleMatched(this->mapMatcher.size(), false);
+        if(this->mapMatcher.size() > 0) {
+                for(const string &variableName : variableNames) {
+                        for(const ua_map_matcher::Match &match : this->mapMatcher.match(variableName)) {
+                                ruleMatched[match.rule] = true;
                         }
                 }
         }
+        size_t rule = 0;
+        for(const MapEntry &entry : this->mapEntries) {
+                // Filtered variables exist in the PV-Manager and are left out on purpose
+                if(entry.pattern ? !ruleMatched[rule++] : variableNames.find(entry.sourceVariableName) == variableNames.end() && !this->isFiltered(entry.sourceVariableName)) {
+                        notMappableVariablesNames.push_back(entry.sourceVariableName);
+                }
+        }
 
         return notMappableVariablesNames;
 }
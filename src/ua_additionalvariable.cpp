@@ -47,7 +47,6 @@ ua_additionalvariable::~ua_additionalvariable()
 }
 
 // Value
-UA_RDPROXY_STRING(ua_additionalvariable, getValue)
 string ua_additionalvariable::getValue() {
   return this->value;
 }
@@ -75,11 +74,15 @@ UA_StatusCode ua_additionalvariable::mapSelfToNamespace() {
 	// know your own nodeId
 	this->ownNodeId = createdNodeId;
 		
-	/* Use a datasource map to map any local getter/setter functions to opcua variables nodes */
-	UA_DataSource_Map mapDs;
-	mapDs.push_back((UA_DataSource_Map_Element) { .typeTemplateId = UA_NODEID_NUMERIC(CSA_NSID, CSA_NSID_ADDITIONAL_VARIABLE_VALUE), oAttr.description, .read=UA_RDPROXY_NAME(ua_additionalvariable, getValue), .write=NULL});
+	/* The value of an additional variable is fixed by the config, so it is written once into the node */
+	UA_String ua_val = UA_STRING((char*) this->value.c_str());
+	UA_Variant ua_var;
+	UA_Variant_setScalar(&ua_var, &ua_val, &UA_TYPES[UA_TYPES_STRING]);
 	
-	this->ua_mapDataSources((void *) this, &mapDs);
+	UA_Value_Map mapValues;
+	mapValues.push_back((UA_Value_Map_Element) { .typeTemplateId = UA_NODEID_NUMERIC(CSA_NSID, CSA_NSID_ADDITIONAL_VARIABLE_VALUE), .description = oAttr.description, .value = ua_var, .onWrite = NULL});
+	
+	this->ua_mapValues((void *) this, &mapValues);
 	
 	return UA_STATUSCODE_GOOD;
 }
@@ -0,0 +1,266 @@
+/* 
+ * This file is part of ChimeraTKs ControlSystem-OPC-UA-Adapter.
+ *
+ * ChimeraTKs ControlSystem-OPC-UA-Adapter is free software: you can 
+ * redistribute it and/or modify it under the terms of the Lesser GNU 
+ * General Public License as published by the Free Software Foundation, 
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ChimeraTKs ControlSystem-OPC-UA-Adapter is distributed in the hope 
+ * that it will be useful, but WITHOUT ANY WARRANTY; without even the 
+ * implied warranty ofMERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+ * See the Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Foobar.  If not, see https://www.gnu.org/licenses/lgpl.html
+ * 
+ * Copyright (c) 2016 Chris Iatrou <Chris_Paul.Iatrou@tu-dresden.de>
+ * Copyright (c) 2016 Julian Rahm  <Julian.Rahm@tu-dresden.de>
+ */
+
+
+#include "ua_map_matcher.h"
+
+#include <algorithm>
+
+using namespace std;
+
+ua_map_matcher::ua_map_matcher() {
+	this->ruleCount = 0;
+}
+
+size_t ua_map_matcher::addGlob(const string &pattern) {
+	GlobRule glob;
+	glob.rule = this->ruleCount++;
+	for(size_t i = 0; i < pattern.size(); i++) {
+		Token token;
+		token.literal = pattern[i];
+		token.type = TOKEN_LITERAL;
+		if(pattern[i] == '*') {
+			token.type = TOKEN_STAR;
+		}
+		else if(pattern[i] == '?') {
+			token.type = TOKEN_ANY;
+		}
+		else if(pattern[i] == '\\' && i + 1 < pattern.size()) {
+			token.literal = pattern[++i];
+		}
+		glob.tokens.push_back(token);
+	}
+	glob.firstPosition = this->positionRule.size();
+	this->positionRule.insert(this->positionRule.end(), glob.tokens.size() + 1, this->globs.size());
+	this->globs.push_back(glob);
+	this->resetAutomaton();
+	return glob.rule;
+}
+
+size_t ua_map_matcher::addRegex(const string &pattern) {
+	RegexRule regex;
+	regex.expression = std::regex(pattern, std::regex::ECMAScript);
+	regex.rule = this->ruleCount++;
+	this->regexes.push_back(regex);
+	return regex.rule;
+}
+
+size_t ua_map_matcher::size() const {
+	return this->ruleCount;
+}
+
+void ua_map_matcher::resetAutomaton() {
+	this->states.clear();
+	this->stateIndex.clear();
+}
+
+void ua_map_matcher::closePositions(vector<uint32_t> &positions) const {
+	// A star may match nothing, so the position behind it is reached as well
+	for(size_t i = 0; i < positions.size(); i++) {
+		const GlobRule &glob = this->globs[this->positionRule[positions[i]]];
+		size_t token = positions[i] - glob.firstPosition;
+		if(token < glob.tokens.size() && glob.tokens[token].type == TOKEN_STAR) {
+			positions.push_back(positions[i] + 1);
+		}
+	}
+	sort(positions.begin(), positions.end());
+	positions.erase(unique(positions.begin(), positions.end()), positions.end());
+}
+
+int32_t ua_map_matcher::findState(vector<uint32_t> &positions) const {
+	this->closePositions(positions);
+	auto known = this->stateIndex.find(positions);
+	if(known != this->stateIndex.end()) {
+		return known->second;
+	}
+
+	State state;
+	state.positions = positions;
+	state.next.assign(256, -1);
+	for(uint32_t position : positions) {
+		const GlobRule &glob = this->globs[this->positionRule[position]];
+		if(position - glob.firstPosition == glob.tokens.size()) {
+			state.accepting.push_back(this->positionRule[position]);
+		}
+	}
+	int32_t index = this->states.size();
+	this->states.push_back(state);
+	this->stateIndex[positions] = index;
+	return index;
+}
+
+int32_t ua_map_matcher::step(int32_t state, unsigned char character) const {
+	int32_t next = this->states[state].next[character];
+	if(next >= 0) {
+		return next;
+	}
+
+	vector<uint32_t> positions;
+	for(uint32_t position : this->states[state].positions) {
+		const GlobRule &glob = this->globs[this->positionRule[position]];
+		size_t token = position - glob.firstPosition;
+		if(token == glob.tokens.size()) {
+			continue;
+		}
+		switch(glob.tokens[token].type) {
+			case TOKEN_STAR:
+				positions.push_back(position);
+				break;
+			case TOKEN_ANY:
+				positions.push_back(position + 1);
+				break;
+			case TOKEN_LITERAL:
+				if((unsigned char) glob.tokens[token].literal == character) {
+					positions.push_back(position + 1);
+				}
+				break;
+		}
+	}
+	next = this->findState(positions);
+	this->states[state].next[character] = next;
+	return next;
+}
+
+bool ua_map_matcher::captureGlob(const GlobRule &glob, const string &name, vector<string> &captures) const {
+	// Wildcard matching with backtracking to the last star, tokenStart holds where every token matched
+	const vector<Token> &tokens = glob.tokens;
+	vector<size_t> tokenStart(tokens.size() + 1, 0);
+	size_t token = 0;
+	size_t character = 0;
+	size_t starToken = string::npos;
+	size_t starCharacter = 0;
+	while(character < name.size()) {
+		if(token < tokens.size() && (tokens[token].type == TOKEN_ANY || (tokens[token].type == TOKEN_LITERAL && tokens[token].literal == name[character]))) {
+			tokenStart[token++] = character++;
+		}
+		else if(token < tokens.size() && tokens[token].type == TOKEN_STAR) {
+			tokenStart[token] = character;
+			starToken = token++;
+			starCharacter = character;
+		}
+		else if(starToken != string::npos) {
+			token = starToken + 1;
+			character = ++starCharacter;
+		}
+		else {
+			return false;
+		}
+	}
+	while(token < tokens.size() && tokens[token].type == TOKEN_STAR) {
+		tokenStart[token++] = character;
+	}
+	if(token != tokens.size()) {
+		return false;
+	}
+	tokenStart[tokens.size()] = name.size();
+
+	captures.push_back(name);
+	for(size_t i = 0; i < tokens.size(); i++) {
+		if(tokens[i].type != TOKEN_LITERAL) {
+			captures.push_back(name.substr(tokenStart[i], tokenStart[i + 1] - tokenStart[i]));
+		}
+	}
+	return true;
+}
+
+vector<size_t> ua_map_matcher::acceptingGlobs(const string &name) const {
+	if(this->globs.empty()) {
+		return vector<size_t>();
+	}
+
+	std::lock_guard<std::mutex> lock(this->automatonMutex);
+	if(this->states.empty()) {
+		// State 0 is the dead state, state 1 the start
+		vector<uint32_t> positions;
+		this->findState(positions);
+		for(const GlobRule &glob : this->globs) {
+			positions.push_back(glob.firstPosition);
+		}
+		this->findState(positions);
+	}
+	int32_t state = 1;
+	for(size_t i = 0; i < name.size() && state != 0; i++) {
+		state = this->step(state, name[i]);
+	}
+	return this->states[state].accepting;
+}
+
+bool ua_map_matcher::matchesAny(const string &name) const {
+	if(!this->acceptingGlobs(name).empty()) {
+		return true;
+	}
+	for(const RegexRule &regex : this->regexes) {
+		if(std::regex_match(name, regex.expression)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+vector<ua_map_matcher::Match> ua_map_matcher::match(const string &name) const {
+	vector<Match> matches;
+
+	for(size_t globIndex : this->acceptingGlobs(name)) {
+		Match match;
+		match.rule = this->globs[globIndex].rule;
+		if(this->captureGlob(this->globs[globIndex], name, match.captures)) {
+			matches.push_back(match);
+		}
+	}
+
+	for(const RegexRule &regex : this->regexes) {
+		std::smatch result;
+		if(std::regex_match(name, result, regex.expression)) {
+			Match match;
+			match.rule = regex.rule;
+			for(size_t i = 0; i < result.size(); i++) {
+				match.captures.push_back(result[i].str());
+			}
+			matches.push_back(match);
+		}
+	}
+
+	sort(matches.begin(), matches.end(), [](const Match &a, const Match &b) { return a.rule < b.rule; });
+	return matches;
+}
+
+string ua_map_matcher::substitute(const string &templateString, const vector<string> &captures) {
+	string result;
+	for(size_t i = 0; i < templateString.size(); i++) {
+		if(templateString[i] != '$' || i + 1 == templateString.size()) {
+			result += templateString[i];
+		}
+		else if(templateString[i + 1] == '$') {
+			result += '$';
+			i++;
+		}
+		else if(templateString[i + 1] >= '0' && templateString[i + 1] <= '9') {
+			size_t capture = templateString[i + 1] - '0';
+			if(capture < captures.size()) {
+				result += captures[capture];
+			}
+			i++;
+		}
+		else {
+			result += templateString[i];
+		}
+	}
+	return result;
+}
@@ -55,14 +55,17 @@ UA_StatusCode ua_mapped_class::ua_mapSelfToNamespace() {
 }
 
 UA_StatusCode ua_mapped_class::ua_unmapSelfFromNamespace() {
-  for (nodePairList::reverse_iterator i = this->ownedNodes.rbegin(); i != this->ownedNodes.rend(); ++i) {
-    UA_NodeId_pair *p = *(i);
-    UA_Server_deleteNode(this->mappedServer, p->targetNodeId, UA_FALSE);
-    this->ownedNodes.remove(*(i));
+  for (nodePairList::const_reverse_iterator i = this->ownedNodes.rbegin(); i != this->ownedNodes.rend(); ++i) {
+    UA_Server_deleteNode(this->mappedServer, i->targetNodeId, UA_FALSE);
   }
+  this->ownedNodes.clear();
   return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode ua_mapped_class::ua_mapDataSources(void* srcClass, UA_DataSource_Map *map) {
   return ua_callProxy_mapDataSources(this->mappedServer, this->ownedNodes, map, srcClass);
 }
+
+UA_StatusCode ua_mapped_class::ua_mapValues(void* srcClass, UA_Value_Map *map) {
+  return ua_callProxy_mapValues(this->mappedServer, this->ownedNodes, map, srcClass);
+}
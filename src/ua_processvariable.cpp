@@ -28,227 +28,187 @@ extern "C" {
 
 #include "ua_proxies.h"
 #include "ua_proxies_callback.h"
+#include "ua_typed_proxy.h"
 
 #include <iostream>
 
-ua_processvariable::ua_processvariable(UA_Server* server, UA_NodeId basenodeid, string namePV, boost::shared_ptr<ControlSystemPVManager> csManager) : ua_mapped_class(server, basenodeid) {
+ua_processvariable::ua_processvariable(UA_Server* server, UA_NodeId basenodeid, string namePV, boost::shared_ptr<ControlSystemPVManager> csManager, bool mapToNamespace) : ua_mapped_class(server, basenodeid) {
   	
   	// FIXME Check if name member of a csManager Parameter
   	this->namePV = namePV;
   	this->nameNew = namePV;
   	this->csManager = csManager;
+  	this->zeroCopyArrays = false;
+  	this->lentSnapshots = boost::make_shared<ua_lent_snapshots>();
+  	this->lentSnapshots->releaseScheduled = false;
+  	this->pumped = false;
+  	this->snapshotVersion = 0;
+  	this->ownNodeId = UA_NODEID_NULL;
+  	this->valueNodeId = UA_NODEID_NULL;
+  	this->writeBatch = nullptr;
+  	this->batched = false;
   	
-  	this->mapSelfToNamespace();
+  	this->resolveProcessVariable();
+  	if(mapToNamespace) {
+  		this->mapSelfToNamespace();
+  	}
+}
+
+template<typename T>
+bool ua_processvariable::resolveAs() {
+	if (*this->valueType != typeid(T)) return false;
+	
+	typename ProcessArray<T>::SharedPtr typedArray = this->csManager->template getProcessArray<T>(this->namePV);
+	this->processArray = typedArray;
+	this->arrayLength = typedArray->accessChannel(0).size();
+	this->typeName = ua_type_traits<T>::typeName();
+	this->valueDataType = &UA_TYPES[ua_type_traits<T>::typeIndex];
+	this->zeroCopyCapable = ua_type_traits<T>::zeroCopy;
+	this->publishUpdate = &ua_processvariable::publishSnapshot<T>;
+	this->finishBatch = &ua_processvariable::finishBatchedWriteAs<T>;
+	if (this->arrayLength == 1) {
+		this->valueRead = ua_typed_proxy<ua_processvariable, T>::read;
+		this->valueWrite = ua_typed_proxy<ua_processvariable, T>::write;
+	}
+	else {
+		this->valueRead = ua_typed_proxy<ua_processvariable, T>::readArray;
+		this->valueWrite = ua_typed_proxy<ua_processvariable, T>::writeArray;
+	}
+	return true;
+}
+
+template<typename T, typename T2, typename... Ts>
+bool ua_processvariable::resolveAs() {
+	return this->resolveAs<T>() || this->resolveAs<T2, Ts...>();
+}
+
+void ua_processvariable::resolveProcessVariable() {
+	this->processVariable = this->csManager->getProcessVariable(this->namePV);
+	this->valueType = &this->processVariable->getValueType();
+	this->readable = this->processVariable->isReadable();
+	this->writeable = this->processVariable->isWriteable();
+	this->arrayLength = 0;
+	this->valueRead = NULL;
+	this->valueWrite = NULL;
+	this->typeName = "Unsupported type";
+	this->valueDataType = NULL;
+	this->zeroCopyCapable = false;
+	this->publishUpdate = NULL;
+	this->finishBatch = NULL;
+	
+	// All value types which are proxied, every type needs a specialization of ua_type_traits
+	this->resolveAs<int8_t, uint8_t, int16_t, uint16_t, int32_t, uint32_t, float, double, string>();
 }
 
 ua_processvariable::~ua_processvariable()
 {
+  this->setZeroCopyArrays(false);
   //* Our ua_mapped_class destructor will take care of deleting our opcua footprint as long as all variables are mapped in this->ownedNodes
 }
 
 // Name
-UA_RDPROXY_STRING(ua_processvariable, getName)
 string ua_processvariable::getName() {
   return this->namePV;
 }
 
 // EngineeringUnit
-UA_WRPROXY_STRING(ua_processvariable, setEngineeringUnit)
+UA_WRHOOK_STRING(ua_processvariable, cacheEngineeringUnit)
 void ua_processvariable::setEngineeringUnit(string engineeringUnit) {
+	if(this->engineeringUnit == engineeringUnit) 
+		return;
+	this->cacheEngineeringUnit(engineeringUnit);
+	this->writeMetadata(CSA_NSID_VARIABLE_UNIT, engineeringUnit);
+}
+
+void ua_processvariable::cacheEngineeringUnit(string engineeringUnit) {
 	this->engineeringUnit = engineeringUnit;
 }
 
-UA_RDPROXY_STRING(ua_processvariable, getEngineeringUnit)
 string ua_processvariable::getEngineeringUnit() {
 	if(!this->engineeringUnit.empty()) {
 		return this->engineeringUnit;
 	}
 	else {
-		this->engineeringUnit = this->csManager->getProcessVariable(this->namePV)->getUnit();
+		this->engineeringUnit = this->processVariable->getUnit();
 		return this->engineeringUnit;
 	}
-	return this->csManager->getProcessVariable(this->namePV)->getUnit();
 }
 
 // Description
-UA_WRPROXY_STRING(ua_processvariable, setDescription)
+UA_WRHOOK_STRING(ua_processvariable, cacheDescription)
 void ua_processvariable::setDescription(string description) {
+	if(this->description == description) 
+		return;
+	this->cacheDescription(description);
+	this->writeMetadata(CSA_NSID_VARIABLE_DESC, description);
+}
+
+void ua_processvariable::cacheDescription(string description) {
 	this->description = description;
 }
 
-UA_RDPROXY_STRING(ua_processvariable, getDescription)
 string ua_processvariable::getDescription() {
 	if(!this->description.empty()) {
 		return this->description;
 	}
 	else {
-		this->description = this->csManager->getProcessVariable(this->namePV)->getDescription();
+		this->description = this->processVariable->getDescription();
 		return this->description;
 	}
-	return this->csManager->getProcessVariable(this->namePV)->getDescription();
 }
 
 // Type
-UA_RDPROXY_STRING(ua_processvariable, getType)
-string ua_processvariable::getType() {		
-    // Note: typeid().name() may return the name; may as well return the symbol's name from the binary though...
-    std::type_info const & valueType = this->csManager->getProcessVariable(this->namePV)->getValueType();
-    if (valueType == typeid(int8_t))        return "int8_t";
-    else if (valueType == typeid(uint8_t))  return "uint8_t";
-    else if (valueType == typeid(int16_t))  return "int16_t";
-    else if (valueType == typeid(uint16_t)) return "uint16_t";
-    else if (valueType == typeid(int32_t))  return "int32_t";
-    else if (valueType == typeid(uint32_t)) return "uint32_t";
-    else if (valueType == typeid(float))    return "float";
-    else if (valueType == typeid(double))   return "double";
-    else if (valueType == typeid(string))   return "string";
-    else                                    return "Unsupported type";
-}
-
-/* Multivariant Read Functions for Value (without template-Foo) */
-#define CREATE_READ_FUNCTION(_p_type) \
-_p_type    ua_processvariable::getValue_##_p_type() { \
-    _p_type v = _p_type(); \
-    if (this->csManager->getProcessVariable(this->namePV)->getValueType() != typeid(_p_type)) return 0; \
-    if (this->csManager->getProcessArray<_p_type>(this->namePV)->accessChannel(0).size() == 1) { \
-			if(this->csManager->getProcessVariable(this->namePV)->isReadable()) { \
-				while(this->csManager->getProcessArray<_p_type>(this->namePV)->readNonBlocking()) {} \
-			} \
-			v = this->csManager->getProcessArray<_p_type>(this->namePV)->accessChannel(0).at(0); \
-		} \
-    return v; \
-} \
-
-
-#define CREATE_READ_FUNCTION_ARRAY(_p_type) \
-std::vector<_p_type>    ua_processvariable::getValue_Array_##_p_type() { \
-    std::vector<_p_type> v; \
-    if (this->csManager->getProcessVariable(this->namePV)->getValueType() != typeid(_p_type)) return v; \
-    if (this->csManager->getProcessArray<_p_type>(this->namePV)->accessChannel(0).size() > 1) { \
-			if(this->csManager->getProcessVariable(this->namePV)->isReadable()) { \
-				while(this->csManager->getProcessArray<_p_type>(this->namePV)->readNonBlocking()) {} \
-			} \
-			v = this->csManager->getProcessArray<_p_type>(this->namePV)->accessChannel(0); \
-		} \
-    return v; \
-} \
-
-
-#define CREATE_WRITE_FUNCTION(_p_type) \
-void ua_processvariable::setValue_##_p_type(_p_type value) { \
-    if (this->csManager->getProcessVariable(this->namePV)->getValueType() != typeid(_p_type)) return; \
-    if (this->csManager->getProcessArray<_p_type>(this->namePV)->accessChannel(0).size() == 1) {   \
-			if (this->csManager->getProcessVariable(this->namePV)->isWriteable()) { \
-				vector<_p_type> valueArray; \
-				valueArray.push_back(value); \
-				this->csManager->getProcessArray<_p_type>(this->namePV)->accessChannel(0) = valueArray; \
-				this->csManager->getProcessArray<_p_type>(this->namePV)->write(); \
-			} \
-		} \
-    return; \
-}
-
-
-#define CREATE_WRITE_FUNCTION_ARRAY(_p_type) \
-void ua_processvariable::setValue_Array_##_p_type(std::vector<_p_type> value) { \
-    if (this->csManager->getProcessVariable(this->namePV)->getValueType() != typeid(_p_type)) return; \
-    if (this->csManager->getProcessArray<_p_type>(this->namePV)->accessChannel(0).size() <= 1) return; \
-			if (this->csManager->getProcessVariable(this->namePV)->isWriteable()) { \
-				int32_t valueSize = this->csManager->getProcessArray<_p_type>(this->namePV)->accessChannel(0).size(); \
-				value.resize(valueSize); \
-				this->csManager->getProcessArray<_p_type>(this->namePV)->accessChannel(0) = value; \
-				this->csManager->getProcessArray<_p_type>(this->namePV)->write(); \
-		} \
-	return; \
-}
-
- UA_RDPROXY_INT8(ua_processvariable, getValue_int8_t);
- CREATE_READ_FUNCTION(int8_t)
- UA_RDPROXY_UINT8(ua_processvariable, getValue_uint8_t);
- CREATE_READ_FUNCTION(uint8_t)
- UA_RDPROXY_INT16(ua_processvariable, getValue_int16_t);
- CREATE_READ_FUNCTION(int16_t)
- UA_RDPROXY_UINT16(ua_processvariable, getValue_uint16_t);
- CREATE_READ_FUNCTION(uint16_t)
- UA_RDPROXY_INT32(ua_processvariable, getValue_int32_t);
- CREATE_READ_FUNCTION(int32_t)
- UA_RDPROXY_UINT32(ua_processvariable, getValue_uint32_t);
- CREATE_READ_FUNCTION(uint32_t)
- UA_RDPROXY_FLOAT(ua_processvariable, getValue_float);
- CREATE_READ_FUNCTION(float)
- UA_RDPROXY_DOUBLE(ua_processvariable, getValue_double);
- CREATE_READ_FUNCTION(double)
- UA_RDPROXY_STRING(ua_processvariable, getValue_string);
- CREATE_READ_FUNCTION(string)
- 
- UA_WRPROXY_INT8(ua_processvariable, setValue_int8_t);
- CREATE_WRITE_FUNCTION(int8_t)
- UA_WRPROXY_UINT8(ua_processvariable, setValue_uint8_t);
- CREATE_WRITE_FUNCTION(uint8_t)
- UA_WRPROXY_INT16(ua_processvariable, setValue_int16_t);
- CREATE_WRITE_FUNCTION(int16_t)
- UA_WRPROXY_UINT16(ua_processvariable, setValue_uint16_t);
- CREATE_WRITE_FUNCTION(uint16_t)
- UA_WRPROXY_INT32(ua_processvariable, setValue_int32_t);
- CREATE_WRITE_FUNCTION(int32_t)
- UA_WRPROXY_UINT32(ua_processvariable, setValue_uint32_t);
- CREATE_WRITE_FUNCTION(uint32_t)
- UA_WRPROXY_FLOAT(ua_processvariable, setValue_float);
- CREATE_WRITE_FUNCTION(float)
- UA_WRPROXY_DOUBLE(ua_processvariable, setValue_double);
- CREATE_WRITE_FUNCTION(double)
- UA_WRPROXY_STRING(ua_processvariable, setValue_string);
- CREATE_WRITE_FUNCTION(string)
-
-// Array
-UA_RDPROXY_ARRAY_INT8(ua_processvariable, getValue_Array_int8_t);
-CREATE_READ_FUNCTION_ARRAY(int8_t)
-UA_RDPROXY_ARRAY_UINT8(ua_processvariable, getValue_Array_uint8_t);
-CREATE_READ_FUNCTION_ARRAY(uint8_t)
-UA_RDPROXY_ARRAY_INT16(ua_processvariable, getValue_Array_int16_t);
-CREATE_READ_FUNCTION_ARRAY(int16_t)
-UA_RDPROXY_ARRAY_UINT16(ua_processvariable, getValue_Array_uint16_t);
-CREATE_READ_FUNCTION_ARRAY(uint16_t)
-UA_RDPROXY_ARRAY_INT32(ua_processvariable, getValue_Array_int32_t);
-CREATE_READ_FUNCTION_ARRAY(int32_t)
-UA_RDPROXY_ARRAY_UINT32(ua_processvariable, getValue_Array_uint32_t);
-CREATE_READ_FUNCTION_ARRAY(uint32_t)
-UA_RDPROXY_ARRAY_FLOAT(ua_processvariable, getValue_Array_float);
-CREATE_READ_FUNCTION_ARRAY(float)
-UA_RDPROXY_ARRAY_DOUBLE(ua_processvariable, getValue_Array_double);
-CREATE_READ_FUNCTION_ARRAY(double)
-UA_RDPROXY_ARRAY_STRING(ua_processvariable, getValue_Array_string);
-CREATE_READ_FUNCTION_ARRAY(string)
-
-UA_WRPROXY_ARRAY_INT8(ua_processvariable, setValue_Array_int8_t);
-CREATE_WRITE_FUNCTION_ARRAY(int8_t)
-UA_WRPROXY_ARRAY_UINT8(ua_processvariable, setValue_Array_uint8_t);
-CREATE_WRITE_FUNCTION_ARRAY(uint8_t)
-UA_WRPROXY_ARRAY_INT16(ua_processvariable, setValue_Array_int16_t);
-CREATE_WRITE_FUNCTION_ARRAY(int16_t)
-UA_WRPROXY_ARRAY_UINT16(ua_processvariable, setValue_Array_uint16_t);
-CREATE_WRITE_FUNCTION_ARRAY(uint16_t)
-UA_WRPROXY_ARRAY_INT32(ua_processvariable, setValue_Array_int32_t);
-CREATE_WRITE_FUNCTION_ARRAY(int32_t)
-UA_WRPROXY_ARRAY_UINT32(ua_processvariable, setValue_Array_uint32_t);
-CREATE_WRITE_FUNCTION_ARRAY(uint32_t)
-UA_WRPROXY_ARRAY_FLOAT(ua_processvariable, setValue_Array_float);
-CREATE_WRITE_FUNCTION_ARRAY(float)
-UA_WRPROXY_ARRAY_DOUBLE(ua_processvariable, setValue_Array_double);
-CREATE_WRITE_FUNCTION_ARRAY(double)
-UA_WRPROXY_ARRAY_STRING(ua_processvariable, setValue_Array_string);
-CREATE_WRITE_FUNCTION_ARRAY(string)
-
-// Just a macro to easy pushing different types of dataSources
-// ... and make sure we lock down writing to receivers in this stage already
- #define PUSH_RDVALUE_TYPE(_p_typeName) { \
- if(this->csManager->getProcessVariable(this->namePV)->isWriteable())  { mapDs.push_back((UA_DataSource_Map_Element) { .typeTemplateId = UA_NODEID_NUMERIC(CSA_NSID, CSA_NSID_VARIABLE_VALUE), .description = description, .read=UA_RDPROXY_NAME(ua_processvariable, getValue_##_p_typeName), .write=UA_WRPROXY_NAME(ua_processvariable, setValue_##_p_typeName) }); } \
-     else                                                                    { mapDs.push_back((UA_DataSource_Map_Element) { .typeTemplateId = UA_NODEID_NUMERIC(CSA_NSID, CSA_NSID_VARIABLE_VALUE), .description = description, .read=UA_RDPROXY_NAME(ua_processvariable, getValue_##_p_typeName), .write=NULL}); }\
- }
-    
-#define PUSH_RDVALUE_ARRAY_TYPE(_p_typeName) { \
-if(this->csManager->getProcessVariable(this->namePV)->isWriteable()) { mapDs.push_back((UA_DataSource_Map_Element) { .typeTemplateId = UA_NODEID_NUMERIC(CSA_NSID, CSA_NSID_VARIABLE_VALUE), .description = description, .read=UA_RDPROXY_NAME(ua_processvariable, getValue_Array_##_p_typeName), .write=UA_WRPROXY_NAME(ua_processvariable, setValue_Array_##_p_typeName) }); } \
-    else                                                                  { mapDs.push_back((UA_DataSource_Map_Element) { .typeTemplateId = UA_NODEID_NUMERIC(CSA_NSID, CSA_NSID_VARIABLE_VALUE), .description = description, .read=UA_RDPROXY_NAME(ua_processvariable, getValue_Array_##_p_typeName), .write=NULL}); } \
+string ua_processvariable::getType() {
+	return this->typeName;
+}
+
+UA_StatusCode ua_processvariable::addMetadataVariable(UA_UInt32 typeTemplateId, const char *browseName, const string &value, 
+                                                      void (*onWrite)(void *handle, const UA_NodeId nodeid, const UA_Variant *data, const UA_NumericRange *range)) {
+	UA_String ua_val = UA_STRING((char*) value.c_str());
+	
+	UA_VariableAttributes vAttr;
+	UA_VariableAttributes_init(&vAttr);
+	vAttr.displayName = UA_LOCALIZEDTEXT((char*) "", (char*) browseName);
+	vAttr.description = UA_LOCALIZEDTEXT((char*) "", (char*) "");
+	vAttr.dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_STRING);
+	vAttr.valueRank = -1;
+	vAttr.accessLevel = UA_ACCESSLEVELMASK_READ;
+	if(onWrite != NULL)
+		vAttr.accessLevel = UA_ACCESSLEVELMASK_WRITE^UA_ACCESSLEVELMASK_READ;
+	vAttr.userAccessLevel = vAttr.accessLevel;
+	UA_Variant_setScalar(&vAttr.value, &ua_val, &UA_TYPES[UA_TYPES_STRING]);
+	
+	UA_NodeId createdNodeId = UA_NODEID_NULL;
+	UA_StatusCode retval = UA_Server_addVariableNode(this->mappedServer, UA_NODEID_NUMERIC(1, 0), this->ownNodeId,
+	                                                 UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), UA_QUALIFIEDNAME(1, (char*) browseName),
+	                                                 UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), vAttr, NULL, &createdNodeId);
+	if(retval != UA_STATUSCODE_GOOD)
+		return retval;
+	
+	UA_NodeId nodeIdVariableType = UA_NODEID_NUMERIC(CSA_NSID, typeTemplateId);
+	NODE_PAIR_PUSH(this->ownedNodes, nodeIdVariableType, createdNodeId)
+	
+	// The value is in place before the hook is attached, so adding the node does not call back into this class
+	if(onWrite != NULL) {
+		UA_ValueCallback callback;
+		callback.handle = (void *) this;
+		callback.onRead = NULL;
+		callback.onWrite = onWrite;
+		retval = UA_Server_setVariableNode_valueCallback(this->mappedServer, createdNodeId, callback);
+	}
+	UA_NodeId_deleteMembers(&createdNodeId);
+	return retval;
+}
+
+void ua_processvariable::writeMetadata(UA_UInt32 typeTemplateId, const string &value) {
+	const UA_NodeId *nodeId = this->ownedNodes.getTargetIdBySourceId( UA_NODEID_NUMERIC(CSA_NSID, typeTemplateId));
+	if(nodeId == nullptr) 
+		return;
+	
+	UA_String ua_val = UA_STRING((char*) value.c_str());
+	UA_Variant ua_var;
+	UA_Variant_setScalar(&ua_var, &ua_val, &UA_TYPES[UA_TYPES_STRING]);
+	UA_Server_writeValue(this->mappedServer, *nodeId, ua_var);
 }
 
 UA_StatusCode ua_processvariable::mapSelfToNamespace() {
@@ -258,59 +218,45 @@ UA_StatusCode ua_processvariable::mapSelfToNamespace() {
     if (UA_NodeId_equal(&this->baseNodeId, &createdNodeId) == UA_TRUE) 
         return 0; // Something went UA_WRING (initializer should have set this!)
 		
+		// The text points into this string, it has to outlive the creation of the node
+		string descriptionText = this->getDescription();
 		UA_LocalizedText description;
-		description = UA_LOCALIZEDTEXT((char*)"en_US", (char*)this->csManager->getProcessVariable(this->namePV)->getDescription().c_str());
+		description = UA_LOCALIZEDTEXT((char*)"en_US", (char*)descriptionText.c_str());
 	
     // Create our toplevel instance
     UA_ObjectAttributes oAttr; 
 		UA_ObjectAttributes_init(&oAttr);
 		
-    oAttr.displayName = UA_LOCALIZEDTEXT_ALLOC("en_US", this->nameNew.c_str());
+    // The server copies the attributes, so they may point into our strings
+    oAttr.displayName = UA_LOCALIZEDTEXT((char*)"en_US", (char*)this->nameNew.c_str());
     oAttr.description = description;
 		
-		if (this->csManager->getProcessVariable(this->namePV)->isWriteable()) {
+		if (this->writeable) {
 			oAttr.userWriteMask = UA_ACCESSLEVELMASK_WRITE;
 			oAttr.writeMask = UA_ACCESSLEVELMASK_WRITE;
 		}
 
-    UA_INSTATIATIONCALLBACK(icb);  
-    UA_Server_addObjectNode(this->mappedServer, UA_NODEID_NUMERIC(1, 0),
-                            this->baseNodeId, UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
-                            UA_QUALIFIEDNAME_ALLOC(1, this->nameNew.c_str()), UA_NODEID_NUMERIC(CSA_NSID, UA_NS2ID_CTKPROCESSVARIABLE), oAttr, &icb, &createdNodeId);
-    	
+    /* The children of ctkProcessVariable are built right here instead of being instantiated from the type:
+     * instantiation would create a Value with a numeric NodeId that had to be browsed for and deleted again.
+     */
+    UA_Server_addObjectNode_withoutMembers(this->mappedServer, UA_NODEID_NUMERIC(1, 0),
+                                           this->baseNodeId, UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                           UA_QUALIFIEDNAME(1, (char*)this->nameNew.c_str()),
+                                           UA_NODEID_NUMERIC(CSA_NSID, UA_NS2ID_CTKPROCESSVARIABLE), oAttr, &createdNodeId);
+    
+	UA_NodeId nodeIdObjectType = UA_NODEID_NUMERIC(CSA_NSID, UA_NS2ID_CTKPROCESSVARIABLE);
+	NODE_PAIR_PUSH(this->ownedNodes, nodeIdObjectType, createdNodeId)
+	
 	// know your own nodeId
 	this->ownNodeId = createdNodeId;	
 	
-	// Delete old "Value" with numeric NodeId
-	UA_BrowseDescription bDesc;
-	UA_BrowseDescription_init(&bDesc);
-	bDesc.browseDirection = UA_BROWSEDIRECTION_FORWARD;
-	bDesc.includeSubtypes = false;
-	bDesc.nodeClassMask = UA_NODECLASS_VARIABLE;
-	bDesc.nodeId = createdNodeId;
-	bDesc.resultMask = UA_BROWSERESULTMASK_ALL;
-	
-	UA_BrowseResult bRes;
-	UA_BrowseResult_init(&bRes);
-	bRes = UA_Server_browse(this->mappedServer, 10, &bDesc);
-	UA_NodeId toDeleteNodeId = UA_NODEID_NULL;
-	for(uint32_t i=0; i < bRes.referencesSize; i++) {
-		UA_String varName = UA_String_fromChars("Value");
-		if(UA_String_equal(&bRes.references[i].browseName.name, &varName)) {
-			UA_Server_deleteNode(this->mappedServer, bRes.references[i].nodeId.nodeId, UA_TRUE);
-			UA_NodeId_copy(&bRes.references[i].nodeId.nodeId, &toDeleteNodeId);
-		}
-	}
-	
-	for (nodePairList::reverse_iterator i = this->ownedNodes.rbegin(); i != this->ownedNodes.rend(); ++i) {
-		UA_NodeId_pair *p = *(i);
-		if(UA_NodeId_equal(&toDeleteNodeId, &p->targetNodeId)) {
-			this->ownedNodes.remove(*(i));
-		}
-	}
-	
-	UA_BrowseDescription_deleteMembers(&bDesc);
-	UA_BrowseResult_deleteMembers(&bRes);
+	/* Metadata does not change behind our back, so it is written once into plain variable values.
+	 * Only the writeable fields get a hook which keeps this class in sync with the node.
+	 */
+	this->addMetadataVariable(CSA_NSID_VARIABLE_NAME, "Name", this->getName(), NULL);
+	this->addMetadataVariable(CSA_NSID_VARIABLE_DESC, "Description", this->getDescription(), UA_WRHOOK_NAME(ua_processvariable, cacheDescription));
+	this->addMetadataVariable(CSA_NSID_VARIABLE_UNIT, "EngineeringUnit", this->getEngineeringUnit(), UA_WRHOOK_NAME(ua_processvariable, cacheEngineeringUnit));
+	this->addMetadataVariable(CSA_NSID_VARIABLE_TYPE, "Type", this->getType(), NULL);
 	
 	UA_NodeId valueNodeId = UA_NODEID_NULL;
 	UA_VariableAttributes vAttr;
@@ -319,82 +265,235 @@ UA_StatusCode ua_processvariable::mapSelfToNamespace() {
   vAttr.displayName = UA_LOCALIZEDTEXT((char*) "en_US",(char*) "Value");
 	vAttr.dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATATYPE);
 
+	UA_Server_addVariableNode(this->mappedServer, UA_NODEID_STRING(1, (char*)this->getName().c_str()), createdNodeId,
+														UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), UA_QUALIFIEDNAME(1, (char*) "Value"),
+														UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), vAttr, NULL, &valueNodeId);
+
+	UA_NodeId nodeIdVariableType = UA_NODEID_NUMERIC(CSA_NSID, CSA_NSID_VARIABLE_VALUE);
+	NODE_PAIR_PUSH(this->ownedNodes, nodeIdVariableType, valueNodeId)
+	this->valueNodeId = valueNodeId;
+	
+	return this->mapValueDataSource();
+}
+
+UA_StatusCode ua_processvariable::mapValueDataSource() {
+	string descriptionText = this->getDescription();
+	UA_LocalizedText description = UA_LOCALIZEDTEXT((char*)"en_US", (char*)descriptionText.c_str());
 	
 	/* Use a datasource map to map any local getter/setter functions to opcua variables nodes */
 	UA_DataSource_Map mapDs;
 	// FIXME: We should not be using std::cout here... Where's our logger?
-	std::type_info const & valueType = this->csManager->getProcessVariable(this->namePV)->getValueType();
-	if (valueType == typeid(int8_t)) {
-//  		vAttr.dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_SBYTE);
-		if(this->csManager->getProcessArray<int8_t>(this->namePV)->accessChannel(0).size() == 1) PUSH_RDVALUE_TYPE(int8_t)
-			else PUSH_RDVALUE_ARRAY_TYPE(int8_t)
-		}
-		else if (valueType == typeid(uint8_t)) {
-//  			vAttr.dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_BYTE);
-			if(this->csManager->getProcessArray<uint8_t>(this->namePV)->accessChannel(0).size() == 1) PUSH_RDVALUE_TYPE(uint8_t)
-			else PUSH_RDVALUE_ARRAY_TYPE(uint8_t)
-		} 
-		else if (valueType == typeid(int16_t)) {
-// 			vAttr.dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_INT16);
-			if(this->csManager->getProcessArray<int16_t>(this->namePV)->accessChannel(0).size() == 1) PUSH_RDVALUE_TYPE(int16_t)
-			else PUSH_RDVALUE_ARRAY_TYPE(int16_t)
+	if (this->valueRead) {
+		mapDs.push_back((UA_DataSource_Map_Element) { .typeTemplateId = UA_NODEID_NUMERIC(CSA_NSID, CSA_NSID_VARIABLE_VALUE), .description = description, .read=this->valueRead, .write=(this->writeable ? this->valueWrite : NULL), .dataType=this->valueDataType, .valueRank=(this->arrayLength == 1 ? -1 : 1) });
+	}
+	else std::cout << "Cannot proxy unknown type " << this->valueType->name()  << std::endl;
+	
+	return this->ua_mapDataSources((void *) this, &mapDs);
+}
+
+UA_StatusCode ua_processvariable::bindToNamespace(const UA_NodeId &objectNodeId) {
+	UA_NodeId nodeIdObjectType = UA_NODEID_NUMERIC(CSA_NSID, UA_NS2ID_CTKPROCESSVARIABLE);
+	NODE_PAIR_PUSH(this->ownedNodes, nodeIdObjectType, objectNodeId)
+	UA_NodeId_copy(&objectNodeId, &this->ownNodeId);
+	
+	UA_BrowseDescription bDesc;
+	UA_BrowseDescription_init(&bDesc);
+	bDesc.nodeId = objectNodeId;
+	bDesc.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+	bDesc.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT);
+	bDesc.nodeClassMask = UA_NODECLASS_VARIABLE;
+	bDesc.resultMask = UA_BROWSERESULTMASK_BROWSENAME;
+	UA_BrowseResult bRes = UA_Server_browse(this->mappedServer, 0, &bDesc);
+	
+	// The children as they are added by mapSelfToNamespace
+	for(size_t i = 0; i < bRes.referencesSize; i++) {
+		string browseName;
+		UASTRING_TO_CPPSTRING(bRes.references[i].browseName.name, browseName);
+		const UA_NodeId &childNodeId = bRes.references[i].nodeId.nodeId;
+		
+		UA_UInt32 typeTemplateId = 0;
+		void (*onWrite)(void *handle, const UA_NodeId nodeid, const UA_Variant *data, const UA_NumericRange *range) = NULL;
+		if(browseName == "Name") {
+			typeTemplateId = CSA_NSID_VARIABLE_NAME;
 		}
-		else if (valueType == typeid(uint16_t)) {
-// 			vAttr.dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_UINT16);
-			if(this->csManager->getProcessArray<uint16_t>(this->namePV)->accessChannel(0).size() == 1) PUSH_RDVALUE_TYPE(uint16_t)
-			else PUSH_RDVALUE_ARRAY_TYPE(uint16_t)
+		else if(browseName == "Description") {
+			typeTemplateId = CSA_NSID_VARIABLE_DESC;
+			onWrite = UA_WRHOOK_NAME(ua_processvariable, cacheDescription);
 		}
-		else if (valueType == typeid(int32_t)) {
-// 			vAttr.dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_INT32);
-			if(this->csManager->getProcessArray<int32_t>(this->namePV)->accessChannel(0).size() == 1) PUSH_RDVALUE_TYPE(int32_t)
-			else PUSH_RDVALUE_ARRAY_TYPE(int32_t)
+		else if(browseName == "EngineeringUnit") {
+			typeTemplateId = CSA_NSID_VARIABLE_UNIT;
+			onWrite = UA_WRHOOK_NAME(ua_processvariable, cacheEngineeringUnit);
 		}
-		else if (valueType == typeid(uint32_t)) {
-// 			vAttr.dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_UINT32);
-			if(this->csManager->getProcessArray<uint32_t>(this->namePV)->accessChannel(0).size() == 1) PUSH_RDVALUE_TYPE(uint32_t)
-			else PUSH_RDVALUE_ARRAY_TYPE(uint32_t)
+		else if(browseName == "Type") {
+			typeTemplateId = CSA_NSID_VARIABLE_TYPE;
 		}
-		else if (valueType == typeid(float)) {
-// 			vAttr.dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_FLOAT);
-			if(this->csManager->getProcessArray<float>(this->namePV)->accessChannel(0).size() == 1) PUSH_RDVALUE_TYPE(float)
-			else PUSH_RDVALUE_ARRAY_TYPE(float)
+		else if(browseName == "Value") {
+			typeTemplateId = CSA_NSID_VARIABLE_VALUE;
+			UA_NodeId_copy(&childNodeId, &this->valueNodeId);
 		}
-		else if (valueType == typeid(double)) {
-// 			vAttr.dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_DOUBLE);
-			if(this->csManager->getProcessArray<double>(this->namePV)->accessChannel(0).size() == 1) PUSH_RDVALUE_TYPE(double)
-			else PUSH_RDVALUE_ARRAY_TYPE(double)
+		else {
+			continue;
 		}
-		else if (valueType == typeid(string)) {
-// 			vAttr.dataType = UA_NODEID_NUMERIC(0, UA_NS0ID_DOUBLE);
-			if(this->csManager->getProcessArray<string>(this->namePV)->accessChannel(0).size() == 1) PUSH_RDVALUE_TYPE(string)
-			else PUSH_RDVALUE_ARRAY_TYPE(string)
+		
+		UA_NodeId nodeIdVariableType = UA_NODEID_NUMERIC(CSA_NSID, typeTemplateId);
+		NODE_PAIR_PUSH(this->ownedNodes, nodeIdVariableType, childNodeId)
+		if(onWrite != NULL) {
+			UA_ValueCallback callback;
+			callback.handle = (void *) this;
+			callback.onRead = NULL;
+			callback.onWrite = onWrite;
+			UA_Server_setVariableNode_valueCallback(this->mappedServer, childNodeId, callback);
 		}
-	else std::cout << "Cannot proxy unknown type " << typeid(valueType).name()  << std::endl;
+	}
+	UA_BrowseResult_deleteMembers(&bRes);
 	
-	UA_Server_addVariableNode(this->mappedServer, UA_NODEID_STRING(1, (char*)this->getName().c_str()), createdNodeId,
-														UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), UA_QUALIFIEDNAME(1, (char*) "Value"),
-														UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), vAttr, &icb, &valueNodeId);
+	if(UA_NodeId_isNull(&this->valueNodeId)) {
+		return UA_STATUSCODE_BADNODEIDUNKNOWN;
+	}
+	return this->mapValueDataSource();
+}
 
-	UA_NodeId nodeIdVariableType = UA_NODEID_NUMERIC(CSA_NSID, CSA_NSID_VARIABLE_VALUE);
-	NODE_PAIR_PUSH(this->ownedNodes, nodeIdVariableType, valueNodeId)
-	
-	mapDs.push_back((UA_DataSource_Map_Element) { .typeTemplateId = UA_NODEID_NUMERIC(CSA_NSID, CSA_NSID_VARIABLE_NAME), UA_LOCALIZEDTEXT((char*)"", (char*)""), .read=UA_RDPROXY_NAME(ua_processvariable, getName), .write=NULL});
-	mapDs.push_back((UA_DataSource_Map_Element) { .typeTemplateId = UA_NODEID_NUMERIC(CSA_NSID, CSA_NSID_VARIABLE_DESC), UA_LOCALIZEDTEXT((char*)"", (char*)""), .read=UA_RDPROXY_NAME(ua_processvariable, getDescription), .write=UA_WRPROXY_NAME(ua_processvariable, setDescription)});
-	mapDs.push_back((UA_DataSource_Map_Element) { .typeTemplateId = UA_NODEID_NUMERIC(CSA_NSID, CSA_NSID_VARIABLE_UNIT), UA_LOCALIZEDTEXT((char*)"", (char*)""), .read=UA_RDPROXY_NAME(ua_processvariable, getEngineeringUnit), .write=UA_WRPROXY_NAME(ua_processvariable, setEngineeringUnit)});
-	mapDs.push_back((UA_DataSource_Map_Element) { .typeTemplateId = UA_NODEID_NUMERIC(CSA_NSID, CSA_NSID_VARIABLE_TYPE), UA_LOCALIZEDTEXT((char*)"", (char*)""), .read=UA_RDPROXY_NAME(ua_processvariable, getType), .write=NULL});
-	
-	this->ua_mapDataSources((void *) this, &mapDs);
-	
-	return UA_STATUSCODE_GOOD;
+vector<UA_NodeId> ua_processvariable::getOwnedNodeIds() {
+	vector<UA_NodeId> nodeIds;
+	for(const UA_NodeId_pair &pair : this->ownedNodes) {
+		nodeIds.push_back(pair.targetNodeId);
+	}
+	return nodeIds;
 }
 	
 /** @brief Reimplement the SourceTimeStamp to timestamp of csa_config
  *
  */
 UA_DateTime ua_processvariable::getSourceTimeStamp() {
-	return (this->csManager->getProcessVariable(this->namePV)->getTimeStamp().seconds * UA_SEC_TO_DATETIME) + (this->csManager->getProcessVariable(this->namePV)->getTimeStamp().nanoSeconds * UA_USEC_TO_DATETIME / 1000LL) + UA_DATETIME_UNIX_EPOCH;
+	if(this->pumped) {
+		return boost::atomic_load(&this->valueSnapshot)->sourceTimeStamp;
+	}
+	return this->receivedTimeStamp();
+}
+
+UA_DateTime ua_processvariable::receivedTimeStamp() {
+	TimeStamp timeStamp = this->processVariable->getTimeStamp();
+	return (timeStamp.seconds * UA_SEC_TO_DATETIME) + (timeStamp.nanoSeconds * UA_USEC_TO_DATETIME / 1000LL) + UA_DATETIME_UNIX_EPOCH;
 }
 
 UA_NodeId ua_processvariable::getOwnNodeId() {
 	return this->ownNodeId;
 }
+
+void ua_processvariable::setZeroCopyArrays(bool enable) {
+	// Only arrays with the same memory layout in C++ and open62541 can be borrowed by a variant
+	if(enable && (this->arrayLength <= 1 || !this->zeroCopyCapable)) {
+		return;
+	}
+	if(!enable) {
+		this->releaseLentSnapshots();
+	}
+	this->zeroCopyArrays = enable;
+}
+
+bool ua_processvariable::isZeroCopyArrays() {
+	return this->zeroCopyArrays;
+}
+
+void ua_processvariable::lendSnapshot(boost::shared_ptr<const void> snapshot) {
+	std::vector<boost::shared_ptr<const void> > &snapshots = this->lentSnapshots->snapshots;
+	if(snapshots.empty() || snapshots.back() != snapshot) {
+		snapshots.push_back(snapshot);
+	}
+	
+	// Only the first lend of an iteration schedules the release, so idle process variables cost nothing
+	if(!this->lentSnapshots->releaseScheduled) {
+		boost::shared_ptr<ua_lent_snapshots> *handle = new boost::shared_ptr<ua_lent_snapshots>(this->lentSnapshots);
+		if(UA_Server_delayedCallback(this->mappedServer, &ua_processvariable::releaseLentSnapshotsDelayed, handle) == UA_STATUSCODE_GOOD) {
+			this->lentSnapshots->releaseScheduled = true;
+		}
+		else {
+			delete handle;
+		}
+	}
+}
+
+void ua_processvariable::releaseLentSnapshotsDelayed(UA_Server *server, void *data) {
+	boost::shared_ptr<ua_lent_snapshots> *handle = static_cast<boost::shared_ptr<ua_lent_snapshots> *>(data);
+	(*handle)->snapshots.clear();
+	(*handle)->releaseScheduled = false;
+	delete handle;
+}
+
+void ua_processvariable::releaseLentSnapshots() {
+	this->lentSnapshots->snapshots.clear();
+}
+
+template<typename T>
+void ua_processvariable::publishSnapshot() {
+	ProcessArray<T> *processArray = static_cast<ProcessArray<T> *>(this->processArray.get());
+	boost::shared_ptr<const ua_value_snapshot_base> snapshot =
+		boost::make_shared<const ua_value_snapshot<T> >(processArray->accessChannel(0), this->receivedTimeStamp(), ++this->snapshotVersion);
+	boost::atomic_store(&this->valueSnapshot, snapshot);
+}
+
+bool ua_processvariable::enableUpdatePump() {
+	if(this->pumped) {
+		return true;
+	}
+	if(!this->readable || this->writeable || !this->publishUpdate) {
+		return false;
+	}
+	
+	// Publish the current value, so reads never find an empty snapshot
+	(this->*publishUpdate)();
+	this->pumped = true;
+	return true;
+}
+
+bool ua_processvariable::isPumped() {
+	return this->pumped;
+}
+
+void ua_processvariable::publishReceivedValue() {
+	(this->*publishUpdate)();
+}
+
+void ua_processvariable::notifyMonitoredItems() {
+	UA_Server_triggerMonitoredItems(this->mappedServer, this->valueNodeId);
+}
+
+void ua_processvariable::setFallbackSamplingInterval(UA_Double interval) {
+	UA_Server_writeMinimumSamplingInterval(this->mappedServer, this->valueNodeId, interval);
+}
+
+UA_StatusCode ua_processvariable::setDeadband(UA_DeadbandType deadbandType, UA_Double deadbandValue) {
+	return UA_Server_setVariableNode_deadband(this->mappedServer, this->valueNodeId, deadbandType, deadbandValue);
+}
+
+void ua_processvariable::setWriteBatch(ua_write_batch *writeBatch) {
+	this->writeBatch = writeBatch;
+}
+
+template<typename T>
+void ua_processvariable::finishBatchedWriteAs(bool send) {
+	ProcessArray<T> *processArray = static_cast<ProcessArray<T> *>(this->processArray.get());
+	if(send) {
+		processArray->write();
+		boost::atomic_store(&this->valueSnapshot, boost::shared_ptr<const ua_value_snapshot_base>());
+	}
+	else if(this->writeBackup) {
+		processArray->accessChannel(0).swap(*boost::static_pointer_cast<std::vector<T> >(this->writeBackup));
+	}
+	this->writeBackup.reset();
+	this->batched = false;
+}
+
+void ua_processvariable::finishBatchedWrite(bool send) {
+	if(this->batched) {
+		(this->*finishBatch)(send);
+	}
+}
+
+ProcessVariable::SharedPtr ua_processvariable::getProcessVariable() {
+	return this->processVariable;
+}
+
+size_t ua_processvariable::getArrayLength() {
+	return this->arrayLength;
+}
@@ -27,122 +27,160 @@
 
 using namespace std;
 
-UA_NodeId *nodePairList_getTargetIdBySourceId(nodePairList pairList, UA_NodeId remoteId) {
-  UA_NodeId *local = nullptr;
-  // cppcheck-suppress postfixOperator                  REASON: List iterator cannot be prefixed
-  for(nodePairList::iterator j = pairList.begin(); j != pairList.end(); j++)
-    if (UA_NodeId_equal(&((*j)->sourceNodeId), &remoteId ) == UA_TRUE) {
-      local = &((*j)->targetNodeId);
-      break;
+nodePairList::~nodePairList() {
+  this->clear();
+}
+
+void nodePairList::push(const UA_NodeId &sourceNodeId, const UA_NodeId &targetNodeId) {
+  UA_NodeId_pair thisNode;
+  UA_NodeId_copy(&sourceNodeId, &thisNode.sourceNodeId);
+  UA_NodeId_copy(&targetNodeId, &thisNode.targetNodeId);
+  this->pairs.push_back(thisNode);
+  this->sourceIndex.emplace(thisNode.sourceNodeId, this->pairs.size() - 1);
+}
+
+void nodePairList::removeByTargetId(const UA_NodeId &targetNodeId) {
+  size_t kept = 0;
+  for(size_t i = 0; i < this->pairs.size(); i++) {
+    if(UA_NodeId_equal(&this->pairs[i].targetNodeId, &targetNodeId) == UA_TRUE) {
+      UA_NodeId_deleteMembers(&this->pairs[i].sourceNodeId);
+      UA_NodeId_deleteMembers(&this->pairs[i].targetNodeId);
+    }
+    else {
+      this->pairs[kept++] = this->pairs[i];
+    }
+  }
+  if(kept == this->pairs.size())
+    return;
+  this->pairs.resize(kept);
+  this->reindex();
+}
+
+void nodePairList::clear() {
+  for(UA_NodeId_pair &p : this->pairs) {
+    UA_NodeId_deleteMembers(&p.sourceNodeId);
+    UA_NodeId_deleteMembers(&p.targetNodeId);
+  }
+  this->pairs.clear();
+  this->sourceIndex.clear();
+}
+
+void nodePairList::reindex() {
+  this->sourceIndex.clear();
+  for(size_t i = 0; i < this->pairs.size(); i++)
+    this->sourceIndex.emplace(this->pairs[i].sourceNodeId, i);
+}
+
+const UA_NodeId *nodePairList::getTargetIdBySourceId(const UA_NodeId &sourceNodeId) const {
+  // Equal keys of the multimap are not ordered, pick the pair pushed first
+  const UA_NodeId *local = nullptr;
+  size_t first = this->pairs.size();
+  auto range = this->sourceIndex.equal_range(sourceNodeId);
+  for(auto i = range.first; i != range.second; ++i) {
+    if(i->second < first) {
+      first = i->second;
+      local = &this->pairs[first].targetNodeId;
     }
+  }
   return local;
 }
 
+const UA_NodeId *nodePairList_getTargetIdBySourceId(const nodePairList &pairList, UA_NodeId remoteId) {
+  return pairList.getTargetIdBySourceId(remoteId);
+}
+
 UA_StatusCode ua_mapInstantiatedNodes(UA_NodeId objectId, UA_NodeId definitionId, void *handle) {
   nodePairList *lst = static_cast<nodePairList*>(handle);
-  
-  UA_NodeId_pair *thisNode = new UA_NodeId_pair;
-  UA_NodeId_copy(&definitionId, &thisNode->sourceNodeId);
-  UA_NodeId_copy(&objectId, &thisNode->targetNodeId);
-  lst->push_back(thisNode);
+  lst->push(definitionId, objectId);
   
   return UA_STATUSCODE_GOOD;
 }
 
-UA_StatusCode ua_callProxy_mapDataSources(UA_Server* server, nodePairList instantiatedNodesList, UA_DataSource_Map *map, void *srcClass) 
+UA_StatusCode ua_callProxy_mapDataSources(UA_Server* server, const nodePairList &instantiatedNodesList, UA_DataSource_Map *map, void *srcClass) 
 {
   UA_StatusCode retval = UA_STATUSCODE_GOOD;
   if (map == nullptr || server == nullptr)
     return retval;
 	
   // Functions are not instantiated... they are just linked to the node. 
-  for (nodePairList::iterator l = instantiatedNodesList.begin(); l != instantiatedNodesList.end(); ++l) {
-    UA_NodeId typeTemplateId = (*l)->sourceNodeId;
-    UA_NodeId instantiatedId = (*l)->targetNodeId;
-   
-    // Check if we have this node in our map
-    UA_DataSource_Map_Element *ele = nullptr;
-    // cppcheck-suppress postfixOperator                REASON: List iterator cannot be prefixed
-    for (UA_DataSource_Map::iterator j=map->begin(); j != map->end(); j++) {
-      UA_DataSource_Map_Element thisEle = *(j);
-      if(UA_NodeId_equal(&typeTemplateId, (const UA_NodeId *) &thisEle.typeTemplateId) == UA_TRUE) {
-        ele = new UA_DataSource_Map_Element;
-        *ele = thisEle;
-        break;
+  for (UA_DataSource_Map::iterator ele = map->begin(); ele != map->end(); ++ele) {
+    UA_DataSourceAttributes attributes;
+    attributes.dataSource.handle = srcClass;
+    attributes.dataSource.read = ele->read;
+    attributes.dataSource.write = ele->write;
+    attributes.description = ele->description;
+    
+    // Set accesslevel depending on callback functions
+    attributes.accessLevel = 0;
+    if(ele->read != NULL)
+      attributes.accessLevel |= UA_ACCESSLEVELMASK_READ;
+    if(ele->write != NULL)
+      attributes.accessLevel |= UA_ACCESSLEVELMASK_WRITE;
+    
+    /* DataType and ValueRank are known by the caller, the value is not read back to infer them.
+     * This used to be a quickfix for subjective data handling by open62541 (02.12.2016)
+     */
+    attributes.dataType = ele->dataType;
+    attributes.valueRank = ele->valueRank;
+    
+    instantiatedNodesList.forEachTargetId(ele->typeTemplateId, [&](const UA_NodeId &instantiatedId) {
+      UA_StatusCode nodeRetval = UA_Server_setVariableNode_dataSourceAttributes(server, instantiatedId, &attributes);
+      if(nodeRetval != UA_STATUSCODE_GOOD)
+        retval = nodeRetval;
+    });
+  }
+  
+  return retval;
+}
+
+UA_StatusCode ua_callProxy_mapValues(UA_Server* server, const nodePairList &instantiatedNodesList, UA_Value_Map *map, void *srcClass)
+{
+  UA_StatusCode retval = UA_STATUSCODE_GOOD;
+  if (map == nullptr || server == nullptr)
+    return retval;
+  
+  for (UA_Value_Map::iterator ele = map->begin(); ele != map->end(); ++ele) {
+    instantiatedNodesList.forEachTargetId(ele->typeTemplateId, [&](const UA_NodeId &instantiatedId) {
+      // Set accesslevel depending on the write hook
+      UA_Byte accessLevel = UA_ACCESSLEVELMASK_READ;
+      if(ele->onWrite != NULL) {
+        accessLevel = UA_ACCESSLEVELMASK_WRITE^UA_ACCESSLEVELMASK_READ;
       }
-    }
-    if (ele == nullptr)
-      continue;
+      UA_Server_writeAccessLevel(server, instantiatedId, accessLevel);
+      // There is currently no high- level function to do this. (02.12.2016)
+      __UA_Server_write(server, &instantiatedId, UA_ATTRIBUTEID_USERACCESSLEVEL, &UA_TYPES[UA_TYPES_BYTE], &accessLevel);
+    
+      UA_Server_writeDescription(server, instantiatedId, ele->description);
     
-    // Found a mapping, now register the dataSource
-    UA_DataSource ds;
-    ds.read = ele->read;		
-    ds.write = ele->write;
-		
-		// Set accesslevel depending on callback functions
-		UA_Byte accessLevel;
-		if(ele->write == NULL && ele->read == NULL) {
-			accessLevel = 0;
-		}
-		if(ele->write != NULL && ele->read == NULL) {
-			accessLevel = UA_ACCESSLEVELMASK_WRITE;
-		}
-		if(ele->write != NULL && ele->read != NULL) {
-			accessLevel = UA_ACCESSLEVELMASK_WRITE^UA_ACCESSLEVELMASK_READ;
-		}
-		if(ele->write == NULL && ele->read != NULL) {
-			accessLevel = UA_ACCESSLEVELMASK_READ;
-		}
-
-		UA_Server_writeAccessLevel(server, instantiatedId, accessLevel);
-		// There is currently no high- level function to do this. (02.12.2016)
-		__UA_Server_write(server, &instantiatedId, UA_ATTRIBUTEID_USERACCESSLEVEL, &UA_TYPES[UA_TYPES_BYTE], &accessLevel);
-		
-		ds.handle = srcClass;
-       
-    UA_Server_setVariableNode_dataSource(server, instantiatedId, ds);
-		
-		UA_Server_writeDescription(server, instantiatedId, ele->description);
-		delete ele; // inhibit memleak warning during static analysis
-		
-	/* Set the right Value Datatype and ValueRank
-	 * -> This is a quickfix for subjective data handling by open62541
-	 * (02.12.2016)
-	 */
-	UA_NodeId datatTypeNodeId = UA_NODEID_NULL;
-    retval = UA_Server_readDataType(server, instantiatedId, &datatTypeNodeId);
-		if(retval == UA_STATUSCODE_GOOD) {
-			const UA_NodeId basedatatype = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATATYPE);
-			UA_Variant variantVal;
-			UA_Variant_init(&variantVal);
-			retval = UA_Server_readValue(server, instantiatedId, &variantVal);
-			if(UA_NodeId_equal(&datatTypeNodeId, &basedatatype) && retval == UA_STATUSCODE_GOOD) {
-				
-				// See IEC 62541-3: OPC Unified Architecture - Part 3: Address space model -> Page 75
-				UA_Int32 valueRank = -2;	
-				if(variantVal.arrayDimensionsSize == 0 && UA_Variant_isScalar(&variantVal)) {
-					// Scalar
-					valueRank = -1;
-				}
-				else {
-					if(variantVal.arrayDimensionsSize > 1) {
-							// OneOrMoreDimensions
-							valueRank = 0;
-					}
-					else {
-						if(variantVal.arrayDimensionsSize == 1 || variantVal.arrayLength) {
-							// OneDimension
-							valueRank = 1;
-						}
-					}
-				}
-				UA_Server_writeValueRank(server, instantiatedId, valueRank);
-			}
-			// the right Datatype
-			retval = UA_Server_writeDataType(server, instantiatedId, variantVal.type->typeId);
-			
-		}
-	}
+      // The value is written before the hook is attached, so mapping does not call back into the class
+      UA_StatusCode nodeRetval = UA_Server_writeValue(server, instantiatedId, ele->value);
+    
+      if(nodeRetval == UA_STATUSCODE_GOOD && ele->onWrite != NULL) {
+        UA_ValueCallback callback;
+        callback.handle = srcClass;
+        callback.onRead = NULL;
+        callback.onWrite = ele->onWrite;
+        nodeRetval = UA_Server_setVariableNode_valueCallback(server, instantiatedId, callback);
+      }
+      if(nodeRetval != UA_STATUSCODE_GOOD)
+        retval = nodeRetval;
+    });
+  }
   
   return retval;
 }
+
+UA_StatusCode ua_numericRange_getSlice(const UA_NumericRange *range, size_t arrayLength, size_t *first, size_t *count) {
+  // Process variables are one dimensional
+  if(range->dimensionsSize != 1 || range->dimensions[0].min > range->dimensions[0].max)
+    return UA_STATUSCODE_BADINDEXRANGEINVALID;
+  if(range->dimensions[0].min >= arrayLength)
+    return UA_STATUSCODE_BADINDEXRANGENODATA;
+
+  *first = range->dimensions[0].min;
+  size_t last = range->dimensions[0].max;
+  if(last >= arrayLength)
+    last = arrayLength - 1;
+  *count = last - *first + 1;
+  return UA_STATUSCODE_GOOD;
+}
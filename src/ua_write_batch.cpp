@@ -0,0 +1,92 @@
+/* 
+ * This file is part of ChimeraTKs ControlSystem-OPC-UA-Adapter.
+ *
+ * ChimeraTKs ControlSystem-OPC-UA-Adapter is free software: you can 
+ * redistribute it and/or modify it under the terms of the Lesser GNU 
+ * General Public License as published by the Free Software Foundation, 
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * ChimeraTKs ControlSystem-OPC-UA-Adapter is distributed in the hope 
+ * that it will be useful, but WITHOUT ANY WARRANTY; without even the 
+ * implied warranty ofMERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+ * See the Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Foobar.  If not, see https://www.gnu.org/licenses/lgpl.html
+ * 
+ * Copyright (c) 2016 Chris Iatrou <Chris_Paul.Iatrou@tu-dresden.de>
+ * Copyright (c) 2016 Julian Rahm  <Julian.Rahm@tu-dresden.de>
+ */
+
+#include "ua_write_batch.h"
+#include "ua_processvariable.h"
+
+static void ua_write_batch_begin(void *handle) {
+	static_cast<ua_write_batch *>(handle)->begin();
+}
+
+static UA_StatusCode ua_write_batch_end(void *handle, UA_Boolean failed) {
+	return static_cast<ua_write_batch *>(handle)->end(failed);
+}
+
+static size_t ua_write_batch_deferredWrites(void *handle) {
+	return static_cast<ua_write_batch *>(handle)->getDeferredWrites();
+}
+
+ua_write_batch::ua_write_batch(bool atomic) {
+	this->atomic = atomic;
+	this->active = false;
+	this->deferredWrites = 0;
+}
+
+void ua_write_batch::attach(UA_Server *server) {
+	UA_WriteRequestCallback callback;
+	callback.handle = this;
+	callback.begin = ua_write_batch_begin;
+	callback.end = ua_write_batch_end;
+	callback.deferredWrites = ua_write_batch_deferredWrites;
+	UA_Server_setWriteRequestCallback(server, callback);
+}
+
+void ua_write_batch::setAtomic(bool atomic) {
+	this->atomic = atomic;
+}
+
+bool ua_write_batch::isAtomic() {
+	return this->atomic;
+}
+
+void ua_write_batch::begin() {
+	this->active = true;
+	this->deferredWrites = 0;
+}
+
+bool ua_write_batch::isActive() {
+	return this->active;
+}
+
+void ua_write_batch::add(ua_processvariable *processvariable) {
+	this->pending.push_back(processvariable);
+}
+
+void ua_write_batch::deferWrite() {
+	this->deferredWrites++;
+}
+
+size_t ua_write_batch::getDeferredWrites() {
+	return this->deferredWrites;
+}
+
+UA_StatusCode ua_write_batch::end(bool failed) {
+	bool send = !(this->atomic && failed);
+	for(ua_processvariable *processvariable : this->pending) {
+		processvariable->finishBatchedWrite(send);
+	}
+	this->pending.clear();
+	this->active = false;
+	
+	if(!send) {
+		return UA_STATUSCODE_BADOPERATIONABANDONED;
+	}
+	return UA_STATUSCODE_GOOD;
+}
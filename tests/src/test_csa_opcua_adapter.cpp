@@ -38,6 +38,8 @@ void CSAOPCUATest::testWithoutPVSet(){
 	BOOST_CHECK(csaOPCUA->isRunning() == true);
 	// is csManager init
 	BOOST_CHECK(csaOPCUA->getControlSystemManager()->getAllProcessVariables().size() == 0);
+	// The config enables the update pump
+	BOOST_CHECK(csaOPCUA->getUpdatePump() != NULL);
 		
 	csaOPCUA->stop();
 	BOOST_CHECK(csaOPCUA->isRunning() != true);
@@ -60,6 +62,9 @@ void CSAOPCUATest::testWithPVSet(){
 	
 	BOOST_CHECK(csaOPCUA->getUAAdapter() != NULL);
 	
+	// Without updatePump in the config reads receive the processvariables inline
+	BOOST_CHECK(csaOPCUA->getUpdatePump() == NULL);
+	
 	csaOPCUA->stop();
 	BOOST_CHECK(csaOPCUA->isRunning() != true);
 	
@@ -4,7 +4,12 @@
 #include <open62541.h>
 
 #include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <test_sample_data.h>
+#include <csa_update_pump.h>
+#include <csa_config.h>
 
 #include <boost/test/included/unit_test.hpp>
 
@@ -22,6 +27,155 @@ extern "C" {
 using namespace boost::unit_test_framework;
 using namespace std;
 
+/*
+ * Server and empty PV-Manager for the test cases which create their own process variables. The process variables
+ * created by addVariable are deleted before the server.
+ */
+struct TestFixtureVariableSet {
+	TestFixtureServerSet serverSet;
+	TestFixtureEmptySet pvSet;
+	vector<ua_processvariable *> variables;
+	
+	TestFixtureVariableSet(const string &testName) {
+		std::cout << "Enter ProcessVariableTest with " << testName << std::endl;
+	}
+	
+	~TestFixtureVariableSet() {
+		for(ua_processvariable *variable : this->variables) {
+			delete variable;
+		}
+		UA_Server_delete(this->serverSet.mappedServer);
+		this->serverSet.server_nl.deleteMembers(&this->serverSet.server_nl);
+	}
+	
+	ua_processvariable *addVariable(const string &name) {
+		ua_processvariable *variable = new ua_processvariable(this->serverSet.mappedServer, this->serverSet.baseNodeId, name, this->pvSet.csManager);
+		this->variables.push_back(variable);
+		return variable;
+	}
+};
+
+/*
+ * Runs a server in its own thread. A wakeup of the update pump is handled like the server loop of the adapter does
+ * it, the loop calls notifyChanged on the server thread.
+ */
+struct TestServerLoop {
+	UA_Server *server;
+	csa_update_pump *pump;
+	volatile UA_Boolean running;
+	std::atomic<bool> changesPending;
+	std::thread *serverThread;
+	
+	TestServerLoop(UA_Server *server, csa_update_pump *pump) : server(server), pump(pump), running(true), changesPending(false) {
+		this->serverThread = new std::thread(&TestServerLoop::run, this);
+	}
+	
+	~TestServerLoop() {
+		this->running = false;
+		this->serverThread->join();
+		delete this->serverThread;
+	}
+	
+	void run() {
+		UA_Server_run_startup(this->server);
+		while(this->running) {
+			UA_Server_run_iterate(this->server, true);
+			if(this->changesPending) {
+				this->pump->notifyChanged();
+				this->changesPending = false;
+			}
+		}
+		UA_Server_run_shutdown(this->server);
+	}
+	
+	void wakeup() {
+		this->changesPending = true;
+	}
+	
+	// Block until the server thread has pushed the changes of the last wakeup into the monitored items
+	void waitForChanges() {
+		while(this->changesPending) {
+			usleep(1000);
+		}
+	}
+};
+
+/*
+ * Data change notifications received by a client for one monitored item
+ */
+struct TestNotifications {
+	uint32_t count;
+	double lastValue;
+	
+	TestNotifications() : count(0), lastValue(0) {}
+	
+	static void handler(UA_UInt32 monId, UA_DataValue *value, void *context) {
+		TestNotifications *notifications = static_cast<TestNotifications *>(context);
+		notifications->count++;
+		if(value->hasValue && value->value.type == &UA_TYPES[UA_TYPES_DOUBLE] && value->value.data != NULL) {
+			size_t last = UA_Variant_isScalar(&value->value) ? 0 : value->value.arrayLength - 1;
+			notifications->lastValue = ((double *) value->value.data)[last];
+		}
+	}
+};
+
+static UA_Client *testConnectClient(uint32_t opcuaPort) {
+	UA_Client *client = UA_Client_new(UA_ClientConfig_standard);
+	string endpointURL = "opc.tcp://localhost:" + to_string(opcuaPort);
+	UA_StatusCode retval = UA_Client_connect(client, endpointURL.c_str());
+	for(int k = 1; retval != UA_STATUSCODE_GOOD && k < 10; k++) {
+		sleep(1);
+		retval = UA_Client_connect(client, endpointURL.c_str());
+	}
+	BOOST_CHECK(retval == UA_STATUSCODE_GOOD);
+	return client;
+}
+
+// Monitor the value of a process variable in a new subscription, which publishes every 10 ms
+static UA_UInt32 testMonitorValue(UA_Client *client, const string &name, TestNotifications *notifications, UA_UInt32 *monitoredItemId = NULL) {
+	UA_SubscriptionSettings settings = UA_SubscriptionSettings_standard;
+	settings.requestedPublishingInterval = 10;
+	UA_UInt32 subscriptionId = 0;
+	BOOST_CHECK(UA_Client_Subscriptions_new(client, settings, &subscriptionId) == UA_STATUSCODE_GOOD);
+	UA_UInt32 newMonitoredItemId = 0;
+	BOOST_CHECK(UA_Client_Subscriptions_addMonitoredItem(client, subscriptionId, UA_NODEID_STRING(1, (char*) name.c_str()), UA_ATTRIBUTEID_VALUE,
+	                                                     &TestNotifications::handler, notifications, &newMonitoredItemId) == UA_STATUSCODE_GOOD);
+	if(monitoredItemId != NULL) {
+		*monitoredItemId = newMonitoredItemId;
+	}
+	return subscriptionId;
+}
+
+// Give a monitored item a DataChangeFilter without deadband of its own, so it takes the deadband of its node
+static void testInheritDeadband(UA_Client *client, UA_UInt32 subscriptionId, UA_UInt32 monitoredItemId, UA_UInt32 clientHandle) {
+	UA_DataChangeFilter filter;
+	UA_DataChangeFilter_init(&filter);
+	filter.trigger = UA_DATACHANGETRIGGER_STATUSVALUE;
+	filter.deadbandType = UA_DEADBANDTYPE_NONE;
+	
+	UA_MonitoredItemModifyRequest item;
+	UA_MonitoredItemModifyRequest_init(&item);
+	item.monitoredItemId = monitoredItemId;
+	item.requestedParameters.clientHandle = clientHandle;
+	item.requestedParameters.samplingInterval = 10;
+	item.requestedParameters.queueSize = 1;
+	item.requestedParameters.discardOldest = true;
+	item.requestedParameters.filter.encoding = UA_EXTENSIONOBJECT_DECODED_NODELETE;
+	item.requestedParameters.filter.content.decoded.type = &UA_TYPES[UA_TYPES_DATACHANGEFILTER];
+	item.requestedParameters.filter.content.decoded.data = &filter;
+	
+	UA_ModifyMonitoredItemsRequest request;
+	UA_ModifyMonitoredItemsRequest_init(&request);
+	request.subscriptionId = subscriptionId;
+	request.itemsToModify = &item;
+	request.itemsToModifySize = 1;
+	UA_ModifyMonitoredItemsResponse response;
+	__UA_Client_Service(client, &request, &UA_TYPES[UA_TYPES_MODIFYMONITOREDITEMSREQUEST],
+	                    &response, &UA_TYPES[UA_TYPES_MODIFYMONITOREDITEMSRESPONSE]);
+	BOOST_CHECK(response.resultsSize == 1 && response.results[0].statusCode == UA_STATUSCODE_GOOD);
+	UA_ModifyMonitoredItemsResponse_deleteMembers(&response);
+}
+
 /*
  * ProcessVariableTest
  * 
@@ -30,6 +184,12 @@ class ProcessVariableTest {
 	public:
 		static void testClassSide();
 		static void testClientSide();
+		static void testArrayReadSnapshot();
+		static void testArrayIndexRange();
+		static void testUpdatePump();
+		static void testUpdatePumpWakeup();
+		static void testDeadband();
+		static void testWriteBatch();
 };
    
 void ProcessVariableTest::testClassSide(){ 
@@ -334,6 +494,30 @@ void ProcessVariableTest::testClassSide(){
 	
 	const UA_NodeId nodeId = test->getOwnNodeId();
 	BOOST_CHECK(!UA_NodeId_isNull(&nodeId));
+	
+	// The object references ctkProcessVariable and holds exactly one Value
+	UA_BrowseDescription bDesc;
+	UA_BrowseDescription_init(&bDesc);
+	bDesc.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+	bDesc.nodeId = nodeId;
+	bDesc.resultMask = UA_BROWSERESULTMASK_ALL;
+	UA_BrowseResult bRes = UA_Server_browse(serverSet->mappedServer, 0, &bDesc);
+	const UA_NodeId hasTypeDefinition = UA_NODEID_NUMERIC(0, UA_NS0ID_HASTYPEDEFINITION);
+	const UA_NodeId pvType = UA_NODEID_NUMERIC(CSA_NSID, UA_NS2ID_CTKPROCESSVARIABLE);
+	const UA_String valueName = UA_STRING((char*) "Value");
+	size_t typeDefinitions = 0;
+	size_t values = 0;
+	for(size_t j=0; j < bRes.referencesSize; j++) {
+		if(UA_NodeId_equal(&bRes.references[j].referenceTypeId, &hasTypeDefinition)) {
+			BOOST_CHECK(UA_NodeId_equal(&bRes.references[j].nodeId.nodeId, &pvType));
+			typeDefinitions++;
+		}
+		if(UA_String_equal(&bRes.references[j].browseName.name, &valueName)) 
+			values++;
+	}
+	BOOST_CHECK(typeDefinitions == 1);
+	BOOST_CHECK(values == 1);
+	UA_BrowseResult_deleteMembers(&bRes);
 		
 	string newName = "";
 	newName = oneProcessVariable->getName();
@@ -507,6 +691,11 @@ void ProcessVariableTest::testClientSide(){
 										if(retvalDatatype != UA_STATUSCODE_GOOD) {
 											BOOST_CHECK(false);
 										}
+										// DataType and ValueRank are set at mapping time and have to match the value
+										BOOST_CHECK(UA_NodeId_equal(&datatypeId, &valueToCheck->type->typeId));
+										UA_Int32 valueRank = 0;
+										BOOST_CHECK(UA_Client_readValueRankAttribute(client, valueNodeId, &valueRank) == UA_STATUSCODE_GOOD);
+										BOOST_CHECK(valueRank == (UA_Variant_isScalar(valueToCheck) ? -1 : 1));
 									}
 										
 										
@@ -542,6 +731,12 @@ void ProcessVariableTest::testClientSide(){
 										UA_String_deleteMembers(&newEU);
 										UASTRING_TO_CPPSTRING(((UA_String) *((UA_String *) euToCheck->data)), engineeringUnit);
 										BOOST_CHECK(engineeringUnit == "mHensel/Iatrou");
+										// The write hook passes the new unit on to the class
+										for(ua_processvariable *var : varList) {
+											if(var->getName() == valName) {
+												BOOST_CHECK(var->getEngineeringUnit() == "mHensel/Iatrou");
+											}
+										}
 										
 										// Check Description -> for all the same
 										UASTRING_TO_CPPSTRING(((UA_String) *((UA_String *) descToCheck->data)), description);
@@ -1166,12 +1361,473 @@ void ProcessVariableTest::testClientSide(){
 	//for(auto ptr : varList) delete ptr;
 }
 
+/*
+ * Benchmark for the array read proxy: every read has to take one snapshot of the PV. The bytes a read copies out of the
+ * process variable are checked for the copying and the zero-copy mode, the measured time per read is only printed.
+ */
+void ProcessVariableTest::testArrayReadSnapshot(){
+	TestFixtureVariableSet fixture("array read snapshot benchmark");
+	TestFixtureServerSet *serverSet = &fixture.serverSet;
+	TestFixtureEmptySet &pvSet = fixture.pvSet;
+	
+	const uint32_t readsPerArray = 100;
+	vector<uint32_t> arraySizes = {1000, 16000, 65535};
+	for(uint32_t arraySize : arraySizes) {
+		string name = "benchDoubleArray_" + to_string(arraySize);
+		ProcessArray<double>::SharedPtr devArray = pvSet.devManager->createProcessArray<double>(deviceToControlSystem, name, arraySize);
+		for(uint32_t i=0; i < arraySize; i++) {
+			devArray->accessChannel(0).at(i) = i;
+		}
+		devArray->write();
+		
+		ua_processvariable *test = fixture.addVariable(name);
+		
+		// Read through the read service, like a client request before encoding. A variant which owns its data was copied out of
+		// the process variable, a borrowed one points into the snapshot.
+		UA_ReadValueId readId;
+		UA_ReadValueId_init(&readId);
+		readId.nodeId = UA_NODEID_STRING(1, (char*) name.c_str());
+		readId.attributeId = UA_ATTRIBUTEID_VALUE;
+		auto readArray = [&](const double *snapshotData, const char *mode) {
+			size_t bytesCopied = 0;
+			auto start = std::chrono::steady_clock::now();
+			for(uint32_t n=0; n < readsPerArray; n++) {
+				UA_DataValue value = UA_Server_read(serverSet->mappedServer, &readId, UA_TIMESTAMPSTORETURN_NEITHER);
+				BOOST_CHECK(value.hasValue && value.value.arrayLength == arraySize);
+				BOOST_CHECK(((double*) value.value.data)[arraySize-1] == arraySize-1);
+				if(value.value.storageType == UA_VARIANT_DATA_NODELETE) {
+					BOOST_CHECK(value.value.data == snapshotData);
+				}
+				else {
+					bytesCopied += value.value.arrayLength * value.value.type->memSize;
+				}
+				UA_DataValue_deleteMembers(&value);
+			}
+			auto end = std::chrono::steady_clock::now();
+			cout << name << " (" << mode << "): " << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / readsPerArray << " us per read" << endl;
+			return bytesCopied / readsPerArray;
+		};
+		
+		// Copying mode, every read copies the whole array once
+		BOOST_CHECK(readArray(nullptr, "copy") == arraySize * sizeof(double));
+		
+		// Zero-copy mode, unchanged arrays share one snapshot and reads copy nothing
+		test->setZeroCopyArrays(true);
+		BOOST_CHECK(test->isZeroCopyArrays());
+		boost::shared_ptr<const vector<double> > snapshot = test->getSnapshot_Array_double();
+		BOOST_CHECK(snapshot->size() == arraySize);
+		BOOST_CHECK(test->getSnapshot_Array_double() == snapshot);
+		BOOST_CHECK(readArray(snapshot->data(), "zero-copy") == 0);
+		
+		// An update publishes a new snapshot, the old one stays valid for its holders
+		devArray->accessChannel(0).at(0) = -1;
+		devArray->write();
+		boost::shared_ptr<const vector<double> > updatedSnapshot = test->getSnapshot_Array_double();
+		BOOST_CHECK(updatedSnapshot != snapshot);
+		BOOST_CHECK(updatedSnapshot->at(0) == -1);
+		BOOST_CHECK(snapshot->at(0) == 0);
+		test->releaseLentSnapshots();
+	}
+}
+
+void ProcessVariableTest::testArrayIndexRange(){
+	TestFixtureVariableSet fixture("array index range");
+	TestFixtureServerSet *serverSet = &fixture.serverSet;
+	TestFixtureEmptySet &pvSet = fixture.pvSet;
+	
+	string name = "rangeInt32Array";
+	pvSet.devManager->createProcessArray<int32_t>(controlSystemToDevice, name, 10);
+	ua_processvariable *test = fixture.addVariable(name);
+	std::vector<int32_t> initValue(10);
+	for(int32_t i=0; i < 10; i++) {
+		initValue.at(i) = i;
+	}
+	test->setValue_Array_int32_t(initValue);
+	
+	UA_ReadValueId readId;
+	UA_ReadValueId_init(&readId);
+	readId.nodeId = UA_NODEID_STRING(1, (char*) name.c_str());
+	readId.attributeId = UA_ATTRIBUTEID_VALUE;
+	
+	// Only the requested slice is returned
+	readId.indexRange = UA_STRING((char*) "2:4");
+	UA_DataValue result = UA_Server_read(serverSet->mappedServer, &readId, UA_TIMESTAMPSTORETURN_NEITHER);
+	BOOST_CHECK(result.status == UA_STATUSCODE_GOOD);
+	BOOST_CHECK(result.value.arrayLength == 3);
+	BOOST_CHECK(((UA_Int32*) result.value.data)[0] == 2);
+	BOOST_CHECK(((UA_Int32*) result.value.data)[2] == 4);
+	UA_DataValue_deleteMembers(&result);
+	
+	// A range exceeding the array is cut at its end
+	readId.indexRange = UA_STRING((char*) "8:20");
+	result = UA_Server_read(serverSet->mappedServer, &readId, UA_TIMESTAMPSTORETURN_NEITHER);
+	BOOST_CHECK(result.status == UA_STATUSCODE_GOOD);
+	BOOST_CHECK(result.value.arrayLength == 2);
+	BOOST_CHECK(((UA_Int32*) result.value.data)[1] == 9);
+	UA_DataValue_deleteMembers(&result);
+	
+	readId.indexRange = UA_STRING((char*) "12:14");
+	result = UA_Server_read(serverSet->mappedServer, &readId, UA_TIMESTAMPSTORETURN_NEITHER);
+	BOOST_CHECK(result.status == UA_STATUSCODE_BADINDEXRANGENODATA);
+	UA_DataValue_deleteMembers(&result);
+	
+	// Partial write updates only the addressed elements
+	UA_Int32 newValues[2] = {100, 101};
+	UA_WriteValue writeValue;
+	UA_WriteValue_init(&writeValue);
+	writeValue.nodeId = UA_NODEID_STRING(1, (char*) name.c_str());
+	writeValue.attributeId = UA_ATTRIBUTEID_VALUE;
+	writeValue.indexRange = UA_STRING((char*) "3:4");
+	writeValue.value.hasValue = UA_TRUE;
+	UA_Variant_setArray(&writeValue.value.value, newValues, 2, &UA_TYPES[UA_TYPES_INT32]);
+	BOOST_CHECK(UA_Server_write(serverSet->mappedServer, &writeValue) == UA_STATUSCODE_GOOD);
+	std::vector<int32_t> csValue = pvSet.csManager->getProcessArray<int32_t>(name)->accessChannel(0);
+	BOOST_CHECK(csValue.at(2) == 2);
+	BOOST_CHECK(csValue.at(3) == 100);
+	BOOST_CHECK(csValue.at(4) == 101);
+	BOOST_CHECK(csValue.at(5) == 5);
+	
+	writeValue.indexRange = UA_STRING((char*) "3:5");
+	BOOST_CHECK(UA_Server_write(serverSet->mappedServer, &writeValue) != UA_STATUSCODE_GOOD);
+	
+	// Values of another type are rejected by the typed proxy
+	UA_Double wrongValues[2] = {1.0, 2.0};
+	writeValue.indexRange = UA_STRING((char*) "3:4");
+	UA_Variant_setArray(&writeValue.value.value, wrongValues, 2, &UA_TYPES[UA_TYPES_DOUBLE]);
+	BOOST_CHECK(UA_Server_write(serverSet->mappedServer, &writeValue) != UA_STATUSCODE_GOOD);
+	BOOST_CHECK(pvSet.csManager->getProcessArray<int32_t>(name)->accessChannel(0).at(3) == 100);
+	BOOST_CHECK(test->getType() == "int32_t");
+	
+	// Zero-copy mode serves the slice out of the snapshot
+	test->setZeroCopyArrays(true);
+	readId.indexRange = UA_STRING((char*) "3:4");
+	result = UA_Server_read(serverSet->mappedServer, &readId, UA_TIMESTAMPSTORETURN_NEITHER);
+	BOOST_CHECK(result.status == UA_STATUSCODE_GOOD);
+	BOOST_CHECK(result.value.arrayLength == 2);
+	BOOST_CHECK(((UA_Int32*) result.value.data)[0] == 100);
+	UA_DataValue_deleteMembers(&result);
+	
+	// A shorter array without range is copied into the process array and padded
+	UA_Int32 shortValues[3] = {7, 8, 9};
+	UA_String_init(&writeValue.indexRange);
+	UA_Variant_setArray(&writeValue.value.value, shortValues, 3, &UA_TYPES[UA_TYPES_INT32]);
+	BOOST_CHECK(UA_Server_write(serverSet->mappedServer, &writeValue) == UA_STATUSCODE_GOOD);
+	csValue = pvSet.csManager->getProcessArray<int32_t>(name)->accessChannel(0);
+	BOOST_CHECK(csValue.size() == 10);
+	BOOST_CHECK(csValue.at(2) == 9);
+	BOOST_CHECK(csValue.at(3) == 0);
+	BOOST_CHECK(csValue.at(9) == 0);
+}
+
+void ProcessVariableTest::testUpdatePump(){
+	TestFixtureVariableSet fixture("update pump");
+	TestFixtureServerSet *serverSet = &fixture.serverSet;
+	TestFixtureEmptySet &pvSet = fixture.pvSet;
+	
+	ProcessArray<double>::SharedPtr devArray = pvSet.devManager->createProcessArray<double>(deviceToControlSystem, "pumpedDoubleArray", 10);
+	pvSet.devManager->createProcessArray<double>(controlSystemToDevice, "notPumpedDoubleArray", 10);
+	pvSet.devManager->createProcessArray<double>(deviceToControlSystem, "idleDoubleArray", 10);
+	ua_processvariable *test = fixture.addVariable("pumpedDoubleArray");
+	ua_processvariable *sender = fixture.addVariable("notPumpedDoubleArray");
+	ua_processvariable *idle = fixture.addVariable("idleDoubleArray");
+	
+	// Pump is not started, values are only received by pumpOnce()
+	csa_update_pump *pump = new csa_update_pump(pvSet.csManager, 10000);
+	BOOST_CHECK(pump->addVariable(test));
+	BOOST_CHECK(test->isPumped());
+	BOOST_CHECK(!pump->addVariable(sender));
+	BOOST_CHECK(!sender->isPumped());
+	BOOST_CHECK(pump->addVariable(idle));
+	
+	// Value changes are pushed, monitored items only poll at the fallback interval, which does not pass within the test
+	BOOST_CHECK(pump->enableMonitoredItemPush(serverSet->mappedServer, 3600000));
+	UA_Double samplingInterval = 0;
+	BOOST_CHECK(UA_Server_readMinimumSamplingInterval(serverSet->mappedServer, UA_NODEID_STRING(1, (char*) "pumpedDoubleArray"), &samplingInterval) == UA_STATUSCODE_GOOD);
+	BOOST_CHECK(samplingInterval == 3600000);
+	
+	devArray->accessChannel(0).at(9) = 42;
+	devArray->write();
+	BOOST_CHECK(test->getValue_Array_double().at(9) == 0);
+	
+	pump->pumpOnce();
+	BOOST_CHECK(test->getValue_Array_double().at(9) == 42);
+	pump->notifyChanged();
+	
+	UA_Variant value;
+	UA_Variant_init(&value);
+	BOOST_CHECK(UA_Server_readValue(serverSet->mappedServer, UA_NODEID_STRING(1, (char*) "pumpedDoubleArray"), &value) == UA_STATUSCODE_GOOD);
+	BOOST_CHECK(value.arrayLength == 10);
+	BOOST_CHECK(((double*) value.data)[9] == 42);
+	UA_Variant_deleteMembers(&value);
+	
+	// Value and source timestamp are taken from the same published snapshot
+	UA_ReadValueId readId;
+	UA_ReadValueId_init(&readId);
+	readId.nodeId = UA_NODEID_STRING(1, (char*) "pumpedDoubleArray");
+	readId.attributeId = UA_ATTRIBUTEID_VALUE;
+	UA_DataValue result = UA_Server_read(serverSet->mappedServer, &readId, UA_TIMESTAMPSTORETURN_SOURCE);
+	BOOST_CHECK(result.hasSourceTimestamp);
+	BOOST_CHECK(result.sourceTimestamp == test->getSourceTimeStamp());
+	BOOST_CHECK(((double*) result.value.data)[9] == 42);
+	UA_DataValue_deleteMembers(&result);
+	
+	// A pumped change reaches its monitored item, so it was pushed and not sampled
+	{
+		TestServerLoop serverLoop(serverSet->mappedServer, pump);
+		pump->setServerWakeup([&serverLoop]() {
+			serverLoop.wakeup();
+		});
+		UA_Client *client = testConnectClient(serverSet->opcuaPort);
+		TestNotifications notifications;
+		UA_UInt32 subscriptionId = testMonitorValue(client, "pumpedDoubleArray", &notifications);
+		TestNotifications idleNotifications;
+		UA_UInt32 idleMonitoredItemId = 0;
+		BOOST_CHECK(UA_Client_Subscriptions_addMonitoredItem(client, subscriptionId, UA_NODEID_STRING(1, (char*) "idleDoubleArray"), UA_ATTRIBUTEID_VALUE,
+		                                                     &TestNotifications::handler, &idleNotifications, &idleMonitoredItemId) == UA_STATUSCODE_GOOD);
+		UA_Client_Subscriptions_manuallySendPublishRequest(client);
+		BOOST_CHECK(notifications.count == 1);
+		BOOST_CHECK(notifications.lastValue == 42);
+		BOOST_CHECK(idleNotifications.count == 1);
+		
+		// Unchanged values are not sampled before the fallback interval
+		UA_Client_Subscriptions_manuallySendPublishRequest(client);
+		BOOST_CHECK(notifications.count == 1);
+		
+		devArray->accessChannel(0).at(9) = 43;
+		devArray->write();
+		pump->pumpOnce();
+		serverLoop.waitForChanges();
+		UA_Client_Subscriptions_manuallySendPublishRequest(client);
+		BOOST_CHECK(notifications.count == 2);
+		BOOST_CHECK(notifications.lastValue == 43);
+		// Only the monitored items of the changed node are sampled
+		BOOST_CHECK(idleNotifications.count == 1);
+		
+		UA_Client_disconnect(client);
+		UA_Client_delete(client);
+		pump->setServerWakeup(nullptr);
+	}
+	
+	delete pump;
+}
+
+void ProcessVariableTest::testUpdatePumpWakeup(){
+	TestFixtureVariableSet fixture("update pump wakeup");
+	
+	ProcessArray<int32_t>::SharedPtr devValue = fixture.pvSet.devManager->createProcessArray<int32_t>(deviceToControlSystem, "wokenInt32", 1);
+	ProcessArray<int32_t>::SharedPtr devTimedValue = fixture.pvSet.devManager->createProcessArray<int32_t>(deviceToControlSystem, "timedInt32", 1);
+	ua_processvariable *test = fixture.addVariable("wokenInt32");
+	ua_processvariable *timed = fixture.addVariable("timedInt32");
+	// The interval does not pass within the test
+	csa_update_pump *pump = new csa_update_pump(fixture.pvSet.csManager, 3600000);
+	BOOST_CHECK(pump->addVariable(test));
+	pump->doStart();
+	usleep(20000);
+	
+	// Within the interval a sent value waits for the wakeup
+	devValue->accessChannel(0).at(0) = 42;
+	devValue->write();
+	usleep(50000);
+	BOOST_CHECK(test->getValue_Array_int32_t().at(0) == 0);
+	
+	pump->wakeup();
+	for(uint32_t i = 0; i < 10000 && test->getValue_Array_int32_t().at(0) != 42; i++) {
+		usleep(1000);
+	}
+	BOOST_CHECK(test->getValue_Array_int32_t().at(0) == 42);
+	
+	// The sleeping pump is woken up by the stop, waiting for its interval would hang the test
+	pump->doStop();
+	BOOST_CHECK(!pump->isRunning());
+	delete pump;
+	
+	// Without any wakeup the value is received after the interval
+	pump = new csa_update_pump(fixture.pvSet.csManager, 20);
+	BOOST_CHECK(pump->addVariable(timed));
+	pump->doStart();
+	devTimedValue->accessChannel(0).at(0) = 7;
+	devTimedValue->write();
+	for(uint32_t i = 0; i < 10000 && timed->getValue_Array_int32_t().at(0) != 7; i++) {
+		usleep(1000);
+	}
+	BOOST_CHECK(timed->getValue_Array_int32_t().at(0) == 7);
+	delete pump;
+}
+
+void ProcessVariableTest::testDeadband(){
+	TestFixtureVariableSet fixture("deadband");
+	
+	ProcessArray<double>::SharedPtr devValue = fixture.pvSet.devManager->createProcessArray<double>(deviceToControlSystem, "noisyDouble", 1);
+	ua_processvariable *test = fixture.addVariable("noisyDouble");
+	
+	BOOST_CHECK(test->setDeadband(UA_DEADBANDTYPE_ABSOLUTE, 0.01) == UA_STATUSCODE_GOOD);
+	BOOST_CHECK(test->setDeadband(UA_DEADBANDTYPE_PERCENT, 5) == UA_STATUSCODE_GOOD);
+	BOOST_CHECK(test->setDeadband(UA_DEADBANDTYPE_NONE, 0) == UA_STATUSCODE_GOOD);
+	BOOST_CHECK(test->setDeadband(UA_DEADBANDTYPE_ABSOLUTE, -1) == UA_STATUSCODE_BADDEADBANDFILTERINVALID);
+	BOOST_CHECK(test->setDeadband((UA_DeadbandType) 3, 1) == UA_STATUSCODE_BADDEADBANDFILTERINVALID);
+	
+	// Every value is pumped and pushed into the monitored item, sampling alone would not see it within the test
+	csa_update_pump *pump = new csa_update_pump(fixture.pvSet.csManager, 10000);
+	BOOST_CHECK(pump->addVariable(test));
+	BOOST_CHECK(pump->enableMonitoredItemPush(fixture.serverSet.mappedServer, 10000));
+	{
+		TestServerLoop serverLoop(fixture.serverSet.mappedServer, pump);
+		pump->setServerWakeup([&serverLoop]() {
+			serverLoop.wakeup();
+		});
+		// The monitored item is created without a filter, it still takes the deadband of the node
+		BOOST_CHECK(test->setDeadband(UA_DEADBANDTYPE_ABSOLUTE, 0.5) == UA_STATUSCODE_GOOD);
+		UA_Client *client = testConnectClient(fixture.serverSet.opcuaPort);
+		TestNotifications notifications;
+		UA_UInt32 monitoredItemId = 0;
+		UA_UInt32 subscriptionId = testMonitorValue(client, "noisyDouble", &notifications, &monitoredItemId);
+		UA_Client_Subscriptions_manuallySendPublishRequest(client);
+		BOOST_CHECK(notifications.count == 1);
+		
+		// Send a value and count the notifications it produced
+		auto sendValue = [&](double value) {
+			uint32_t count = notifications.count;
+			devValue->accessChannel(0).at(0) = value;
+			devValue->write();
+			pump->pumpOnce();
+			serverLoop.waitForChanges();
+			UA_Client_Subscriptions_manuallySendPublishRequest(client);
+			return notifications.count - count;
+		};
+		
+		// Absolute deadband around the last reported value
+		BOOST_CHECK(sendValue(10.0) == 1);
+		BOOST_CHECK(sendValue(10.3) == 0);
+		BOOST_CHECK(sendValue(9.6) == 0);
+		BOOST_CHECK(sendValue(10.6) == 1);
+		BOOST_CHECK(notifications.lastValue == 10.6);
+		BOOST_CHECK(sendValue(10.2) == 0);
+		
+		// Percent deadband relative to the last reported value, the first value after the change is always reported
+		BOOST_CHECK(test->setDeadband(UA_DEADBANDTYPE_PERCENT, 5) == UA_STATUSCODE_GOOD);
+		testInheritDeadband(client, subscriptionId, monitoredItemId, 1);
+		BOOST_CHECK(sendValue(100.0) == 1);
+		BOOST_CHECK(sendValue(104.0) == 0);
+		BOOST_CHECK(sendValue(96.0) == 0);
+		BOOST_CHECK(sendValue(94.0) == 1);
+		BOOST_CHECK(notifications.lastValue == 94.0);
+		
+		UA_Client_disconnect(client);
+		UA_Client_delete(client);
+		pump->setServerWakeup(nullptr);
+	}
+	delete pump;
+}
+
+void ProcessVariableTest::testWriteBatch(){
+	TestFixtureVariableSet fixture("write batch");
+	TestFixtureServerSet *serverSet = &fixture.serverSet;
+	TestFixtureEmptySet &pvSet = fixture.pvSet;
+	
+	ProcessArray<int32_t>::SharedPtr devFirst = pvSet.devManager->createProcessArray<int32_t>(controlSystemToDevice, "batchFirst", 1);
+	ProcessArray<int32_t>::SharedPtr devSecond = pvSet.devManager->createProcessArray<int32_t>(controlSystemToDevice, "batchSecond", 1);
+	ua_processvariable *first = fixture.addVariable("batchFirst");
+	ua_processvariable *second = fixture.addVariable("batchSecond");
+	
+	// A plain node, it is not part of the batch
+	UA_Int32 plainValue = 0;
+	UA_VariableAttributes vAttr;
+	UA_VariableAttributes_init(&vAttr);
+	vAttr.displayName = UA_LOCALIZEDTEXT((char*) "en_US", (char*) "batchPlain");
+	vAttr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+	vAttr.userAccessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+	UA_Variant_setScalar(&vAttr.value, &plainValue, &UA_TYPES[UA_TYPES_INT32]);
+	BOOST_CHECK(UA_Server_addVariableNode(serverSet->mappedServer, UA_NODEID_STRING(1, (char*) "batchPlain"), serverSet->baseNodeId,
+	                                      UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), UA_QUALIFIEDNAME(1, (char*) "batchPlain"),
+	                                      UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), vAttr, NULL, NULL) == UA_STATUSCODE_GOOD);
+	
+	ua_write_batch batch;
+	batch.attach(serverSet->mappedServer);
+	first->setWriteBatch(&batch);
+	second->setWriteBatch(&batch);
+	
+	UA_Int32 values[3] = {42, 42, 7};
+	UA_Double wrongValue = 1.0;
+	UA_WriteValue nodesToWrite[3];
+	const char *names[3] = {"batchFirst", "batchSecond", "batchPlain"};
+	for(size_t i = 0; i < 3; i++) {
+		UA_WriteValue_init(&nodesToWrite[i]);
+		nodesToWrite[i].nodeId = UA_NODEID_STRING(1, (char*) names[i]);
+		nodesToWrite[i].attributeId = UA_ATTRIBUTEID_VALUE;
+		nodesToWrite[i].value.hasValue = UA_TRUE;
+		UA_Variant_setScalar(&nodesToWrite[i].value.value, &values[i], &UA_TYPES[UA_TYPES_INT32]);
+	}
+	UA_WriteRequest request;
+	UA_WriteRequest_init(&request);
+	request.nodesToWrite = nodesToWrite;
+	request.nodesToWriteSize = 3;
+	
+	{
+		TestServerLoop serverLoop(serverSet->mappedServer, nullptr);
+		UA_Client *client = testConnectClient(serverSet->opcuaPort);
+		
+		// Both process variables of the request are sent, each of them once
+		UA_WriteResponse response = UA_Client_Service_write(client, request);
+		BOOST_CHECK(response.resultsSize == 3);
+		for(size_t i = 0; i < response.resultsSize; i++) {
+			BOOST_CHECK(response.results[i] == UA_STATUSCODE_GOOD);
+		}
+		UA_WriteResponse_deleteMembers(&response);
+		BOOST_CHECK(devFirst->readNonBlocking());
+		BOOST_CHECK(devFirst->accessChannel(0).at(0) == 42);
+		BOOST_CHECK(!devFirst->readNonBlocking());
+		BOOST_CHECK(devSecond->readNonBlocking());
+		BOOST_CHECK(devSecond->accessChannel(0).at(0) == 42);
+		
+		// Atomic batches discard the process variable writes if one write of the request failed
+		batch.setAtomic(true);
+		values[0] = 43;
+		values[2] = 8;
+		UA_Variant_setScalar(&nodesToWrite[1].value.value, &wrongValue, &UA_TYPES[UA_TYPES_DOUBLE]);
+		response = UA_Client_Service_write(client, request);
+		BOOST_CHECK(response.resultsSize == 3);
+		if(response.resultsSize == 3) {
+			BOOST_CHECK(response.results[0] == UA_STATUSCODE_BADOPERATIONABANDONED);
+			BOOST_CHECK(response.results[1] != UA_STATUSCODE_GOOD);
+			BOOST_CHECK(response.results[1] != UA_STATUSCODE_BADOPERATIONABANDONED);
+			// The plain node was written, so its result stays good
+			BOOST_CHECK(response.results[2] == UA_STATUSCODE_GOOD);
+		}
+		UA_WriteResponse_deleteMembers(&response);
+		BOOST_CHECK(!devFirst->readNonBlocking());
+		BOOST_CHECK(!devSecond->readNonBlocking());
+		BOOST_CHECK(first->getValue_int32_t() == 42);
+		
+		UA_Variant plain;
+		UA_Variant_init(&plain);
+		BOOST_CHECK(UA_Client_readValueAttribute(client, UA_NODEID_STRING(1, (char*) "batchPlain"), &plain) == UA_STATUSCODE_GOOD);
+		BOOST_CHECK(plain.type == &UA_TYPES[UA_TYPES_INT32] && *(UA_Int32*) plain.data == 8);
+		UA_Variant_deleteMembers(&plain);
+		
+		UA_Client_disconnect(client);
+		UA_Client_delete(client);
+	}
+	
+	// Local writes are not bracketed by a request, so they are sent immediately
+	UA_Int32 value = 44;
+	UA_Variant variant;
+	UA_Variant_setScalar(&variant, &value, &UA_TYPES[UA_TYPES_INT32]);
+	BOOST_CHECK(UA_Server_writeValue(serverSet->mappedServer, UA_NODEID_STRING(1, (char*) "batchFirst"), variant) == UA_STATUSCODE_GOOD);
+	BOOST_CHECK(devFirst->readNonBlocking());
+	BOOST_CHECK(devFirst->accessChannel(0).at(0) == 44);
+}
 
 class ProcessVariableTestSuite: public test_suite {
 	public:
 		ProcessVariableTestSuite() : test_suite("ua_processvariable Test Suite") {
 			add(BOOST_TEST_CASE(&ProcessVariableTest::testClassSide));
 			add(BOOST_TEST_CASE(&ProcessVariableTest::testClientSide));
+			add(BOOST_TEST_CASE(&ProcessVariableTest::testArrayReadSnapshot));
+			add(BOOST_TEST_CASE(&ProcessVariableTest::testArrayIndexRange));
+			add(BOOST_TEST_CASE(&ProcessVariableTest::testUpdatePump));
+			add(BOOST_TEST_CASE(&ProcessVariableTest::testUpdatePumpWakeup));
+			add(BOOST_TEST_CASE(&ProcessVariableTest::testDeadband));
+			add(BOOST_TEST_CASE(&ProcessVariableTest::testWriteBatch));
     }
 };
 
@@ -5,6 +5,9 @@
 
 #include <boost/test/included/unit_test.hpp>
 
+#include <atomic>
+#include <unistd.h>
+
 #include "ChimeraTK/ControlSystemAdapter/ControlSystemPVManager.h"
 #include "ChimeraTK/ControlSystemAdapter/DevicePVManager.h"
 #include "ChimeraTK/ControlSystemAdapter/PVManager.h"
@@ -16,6 +19,7 @@ using namespace std;
 class UAAdapterTest {
         public:
                 static void testExampleSet();
+                static void testServerLoop();
 };
 
 void UAAdapterTest::testExampleSet() {
@@ -65,6 +69,10 @@ void UAAdapterTest::testExampleSet() {
         folderNodeId = adapter->existFolderPath(ownNodeId, pathVector);
         BOOST_CHECK(!UA_NodeId_isNull(&folderNodeId));
 
+        // The existing part of the path was reused
+        UA_NodeId partFolderNodeId = adapter->existFolder(adapter->existFolder(ownNodeId, "test"), "test1");
+        BOOST_CHECK(UA_NodeId_equal(&partFolderNodeId, &folderNodeId));
+
         // Double creation of folder, should be the same folder nodeid
         UA_NodeId existingFolderNodeId = adapter->createFolderPath(ownNodeId, pathVector);
         BOOST_CHECK(UA_NodeId_equal(&existingFolderNodeId, &folderNodeId));
@@ -81,6 +89,95 @@ void UAAdapterTest::testExampleSet() {
         /* Check if both var are not mapped */
         cout << "Größe von: " << adapter->getAllNotMappableVariablesNames().size() << endl;
         BOOST_CHECK(adapter->getAllNotMappableVariablesNames().size() == 5);
+        // Bulk mapping creates the same variables in the same order
+        ua_uaadapter *bulkAdapter = new ua_uaadapter("./uamapping_test_2.xml");
+        vector<string> allNames;
+        for(auto processVar:tfExampleSet.csManager.get()->getAllProcessVariables()) {
+                allNames.push_back(processVar.get()->getName());
+        }
+        bulkAdapter->addVariables(allNames, tfExampleSet.csManager);
+        BOOST_CHECK(bulkAdapter->getVariables().size() == adapter->getVariables().size());
+        for(size_t i = 0; i < bulkAdapter->getVariables().size() && i < adapter->getVariables().size(); i++) {
+                BOOST_CHECK(bulkAdapter->getVariables()[i]->getName() == adapter->getVariables()[i]->getName());
+        }
+        BOOST_CHECK(bulkAdapter->getAllNotMappableVariablesNames().size() == 5);
+        delete bulkAdapter;
+
+        // Lazy instantiation commits the variables on first access
+        ua_uaadapter *lazyAdapter = new ua_uaadapter("./uamapping_test_lazy.xml");
+        lazyAdapter->addVariables(allNames, tfExampleSet.csManager);
+        BOOST_CHECK(lazyAdapter->getVariables().size() == 0);
+        BOOST_CHECK(lazyAdapter->getDeferredVariableCount() == allNames.size());
+        BOOST_CHECK(lazyAdapter->getAllNotMappableVariablesNames().size() == 5);
+
+        // Browsing a folder commits the variables mapped below it, the folders exist from the start
+        UA_NodeId lazyFolderNodeId = lazyAdapter->existFolder(lazyAdapter->getOwnNodeId(), "WinBB");
+        lazyFolderNodeId = lazyAdapter->existFolderPath(lazyFolderNodeId, xmlHandler->praseVariablePath("EastSide/LINAC"));
+        BOOST_CHECK(!UA_NodeId_isNull(&lazyFolderNodeId));
+        UA_BrowseDescription lazyBrowse;
+        UA_BrowseDescription_init(&lazyBrowse);
+        lazyBrowse.nodeId = lazyFolderNodeId;
+        lazyBrowse.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+        lazyBrowse.resultMask = UA_BROWSERESULTMASK_ALL;
+        UA_BrowseResult lazyBrowseResult = UA_Server_browse(lazyAdapter->getMappedServer(), 0, &lazyBrowse);
+        UA_BrowseResult_deleteMembers(&lazyBrowseResult);
+        BOOST_CHECK(lazyAdapter->getVariables().size() == 1);
+        BOOST_CHECK(lazyAdapter->getVariables()[0]->getName() == "Dein/Name/ist/int32Scalar");
+
+        // Reading the Value node commits its variable
+        string lazyName = allNames[0] == "Dein/Name/ist/int32Scalar" ? allNames[1] : allNames[0];
+        UA_Variant lazyValue;
+        UA_Variant_init(&lazyValue);
+        UA_Server_readValue(lazyAdapter->getMappedServer(), UA_NODEID_STRING(1, (char *) lazyName.c_str()), &lazyValue);
+        UA_Variant_deleteMembers(&lazyValue);
+        BOOST_CHECK(lazyAdapter->getVariables().size() == 2);
+        BOOST_CHECK(lazyAdapter->getDeferredVariableCount() == allNames.size() - 2);
+        delete lazyAdapter;
+
+        // Pattern rules, captures are used in rename and <folder>
+        ua_uaadapter *patternAdapter = new ua_uaadapter("./uamapping_test_pattern.xml");
+        patternAdapter->addVariables(allNames, tfExampleSet.csManager);
+        UA_NodeId patternFolderNodeId = patternAdapter->existFolder(patternAdapter->getOwnNodeId(), "Scalars");
+        BOOST_CHECK(!UA_NodeId_isNull(&patternFolderNodeId));
+        patternFolderNodeId = patternAdapter->existFolder(patternFolderNodeId, "Dein");
+        BOOST_CHECK(!UA_NodeId_isNull(&patternFolderNodeId));
+        // Mein/Name/ist/uint32Scalar is excluded
+        BOOST_CHECK(patternAdapter->getFilteredVariableCount() == 2);
+        BOOST_CHECK(patternAdapter->isFiltered("Mein/Name/ist/uint32Scalar"));
+        patternFolderNodeId = patternAdapter->existFolder(patternAdapter->getOwnNodeId(), "Scalars");
+        patternFolderNodeId = patternAdapter->existFolder(patternFolderNodeId, "Mein");
+        BOOST_CHECK(UA_NodeId_isNull(&patternFolderNodeId));
+        patternFolderNodeId = patternAdapter->existFolder(patternAdapter->getOwnNodeId(), "Arrays");
+        patternFolderNodeId = patternAdapter->existFolder(patternFolderNodeId, "Size15");
+        BOOST_CHECK(!UA_NodeId_isNull(&patternFolderNodeId));
+        vector<string> patternNotMappable = patternAdapter->getAllNotMappableVariablesNames();
+        BOOST_CHECK(patternNotMappable.size() == 1);
+        BOOST_CHECK(patternNotMappable.size() == 1 && patternNotMappable[0] == "nothing*");
+        delete patternAdapter;
+
+        // The first start writes the snapshot, the second one restores the address space from it
+        remove("./uamapping_test_snapshot.bin");
+        ua_uaadapter *snapshotAdapter = new ua_uaadapter("./uamapping_test_snapshot.xml");
+        snapshotAdapter->addVariables(allNames, tfExampleSet.csManager);
+        BOOST_CHECK(!snapshotAdapter->isRestoredFromSnapshot());
+        size_t snapshotVariables = snapshotAdapter->getVariables().size();
+        delete snapshotAdapter;
+
+        snapshotAdapter = new ua_uaadapter("./uamapping_test_snapshot.xml");
+        snapshotAdapter->addVariables(allNames, tfExampleSet.csManager);
+        BOOST_CHECK(snapshotAdapter->isRestoredFromSnapshot());
+        BOOST_CHECK(snapshotAdapter->getVariables().size() == snapshotVariables);
+        UA_NodeId snapshotFolderNodeId = snapshotAdapter->existFolder(snapshotAdapter->getOwnNodeId(), "WinAA");
+        snapshotFolderNodeId = snapshotAdapter->existFolderPath(snapshotFolderNodeId, xmlHandler->praseVariablePath("NorthSide/LINAC/partA"));
+        BOOST_CHECK(!UA_NodeId_isNull(&snapshotFolderNodeId));
+        UA_Variant snapshotValue;
+        UA_Variant_init(&snapshotValue);
+        BOOST_CHECK(UA_Server_readValue(snapshotAdapter->getMappedServer(), UA_NODEID_STRING(1, (char *) allNames[0].c_str()), &snapshotValue) == UA_STATUSCODE_GOOD);
+        BOOST_CHECK(!UA_Variant_isEmpty(&snapshotValue));
+        UA_Variant_deleteMembers(&snapshotValue);
+        delete snapshotAdapter;
+        remove("./uamapping_test_snapshot.bin");
+
         // Check if timestamp is not enmpty
         string dateTime = "";
         UASTRING_TO_CPPSTRING(UA_DateTime_toString(adapter->getSourceTimeStamp()), dateTime);
@@ -91,10 +188,53 @@ void UAAdapterTest::testExampleSet() {
 
 }
 
+void UAAdapterTest::testServerLoop() {
+        cout << "UAAdapterTest with server loop started." << endl;
+        ua_uaadapter *adapter = new ua_uaadapter("./uamapping_test_2.xml");
+        std::atomic<uint32_t> wakeups(0);
+        adapter->setWakeupListener([&wakeups]() {
+                wakeups++;
+        });
+        adapter->doStart();
+
+        // A wakeup from another thread calls the listener on the server thread
+        adapter->wakeup();
+        for(uint32_t i = 0; i < 1000 && wakeups == 0; i++) {
+                usleep(1000);
+        }
+        BOOST_CHECK(wakeups == 1);
+
+        // Each connection gets the socket number of the one closed before, it has to be served all the same
+        UA_NodeId ownNodeId = adapter->getOwnNodeId();
+        for(uint32_t n = 0; n < 3; n++) {
+                UA_Client *client = UA_Client_new(UA_ClientConfig_standard);
+                UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:16665");
+                for(int k = 1; retval != UA_STATUSCODE_GOOD && k < 10; k++) {
+                        sleep(1);
+                        retval = UA_Client_connect(client, "opc.tcp://localhost:16665");
+                }
+                BOOST_CHECK(retval == UA_STATUSCODE_GOOD);
+                UA_QualifiedName browseName;
+                UA_QualifiedName_init(&browseName);
+                BOOST_CHECK(UA_Client_readBrowseNameAttribute(client, ownNodeId, &browseName) == UA_STATUSCODE_GOOD);
+                UA_QualifiedName_deleteMembers(&browseName);
+                UA_Client_disconnect(client);
+                UA_Client_delete(client);
+                // Let the server close the connection, so its socket number is free again
+                usleep(20000);
+        }
+        BOOST_CHECK(wakeups == 1);
+
+        adapter->doStop();
+        adapter->setWakeupListener(nullptr);
+        delete adapter;
+}
+
 class UAAdapterTestSuite: public test_suite {
         public:
                 UAAdapterTestSuite() : test_suite("ua_uaadapter Test Suite") {
                         add(BOOST_TEST_CASE(&UAAdapterTest::testExampleSet));
+                        add(BOOST_TEST_CASE(&UAAdapterTest::testServerLoop));
     }
 };
 